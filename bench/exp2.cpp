@@ -0,0 +1,94 @@
+//============================================================================================================
+//!
+//! \file exp2.cpp
+//!
+//! \brief Benchmark of GControls::fastExp2() against the pow calls it replaced.
+//!
+//! Not part of the plugin, so it lives outside src/.  It needs the plugin header and the SDK headers only:
+//!
+//!     g++ -std=c++11 -O3 -march=nehalem -funsafe-math-optimizations -Isrc -I$RACK_DIR/include
+//!         -I$RACK_DIR/dep/include bench/exp2.cpp -o exp2 && ./exp2
+//!
+//! The error is checked against std::exp2 in double for every float fraction in [0, 1), which covers every
+//! input, as the integer part only scales the result by an exact power of two.  Each form is timed over
+//! pitches in [-5, 5] V, as the bank converts them, and the fastest of several runs is reported.
+//!
+//============================================================================================================
+
+#include "Gratrix.hpp"
+
+#include <chrono>
+#include <cstdio>
+
+using simd::float_4;
+
+//------------------------------------------------------------------------------------------------------------
+//! \brief The measurements.
+
+static constexpr int SIZE   = 4096;  // values per pass, 16 KB, so the inputs stay in L1
+static constexpr int PASSES = 2000;
+static constexpr int RUNS   = 15;    // the fastest run is reported
+
+alignas(16) static float inputs[SIZE];
+alignas(16) static float outputs[SIZE];
+
+static double relativeError(float x, float y) {
+	return std::fabs(y / std::exp2(double(x)) - 1.0);
+}
+
+static void maxError() {
+	double scalar = 0, vector = 0;
+	alignas(16) float x[4];
+	int n = 0;
+
+	for (float f = 0.f; f < 1.f; f = std::nextafter(f, 1.f)) {
+		scalar = std::fmax(scalar, relativeError(f, GControls::fastExp2(f)));
+
+		x[n++] = f;
+		if (n == 4) {
+			float_4 y = GControls::fastExp2(float_4::load(x));
+			for (int j = 0; j < 4; j++) vector = std::fmax(vector, relativeError(x[j], y[j]));
+			n = 0;
+		}
+	}
+
+	std::printf("max relative error  float %.2e  float_4 %.2e  (%.4f cents)\n", scalar, vector, 1200.0 * std::log2(1.0 + std::fmax(scalar, vector)));
+}
+
+template <typename Body>
+static void measure(const char *name, Body body) {
+	double ns = INFINITY;
+	for (int run = 0; run < RUNS; run++) {
+		auto t0 = std::chrono::steady_clock::now();
+		for (int pass = 0; pass < PASSES; pass++) {
+			body();
+			asm volatile("" ::: "memory");  // stop the passes being folded into one
+		}
+		auto t1 = std::chrono::steady_clock::now();
+		ns = std::fmin(ns, std::chrono::duration<double, std::nano>(t1 - t0).count() / (double(SIZE) * PASSES));
+	}
+	std::printf("%-22s %5.2f ns per value\n", name, ns);
+}
+
+int main() {
+	for (int i = 0; i < SIZE; i++) inputs[i] = -5.f + 10.f * i / SIZE;
+
+	maxError();
+
+	// Before: powf per voice, or simd::pow over a float_4 of voices
+	measure("powf(2, x)", [] {
+		for (int i = 0; i < SIZE; i++) outputs[i] = std::pow(2.f, inputs[i]);
+	});
+	measure("simd::pow(2, x)", [] {
+		for (int i = 0; i < SIZE; i += 4) simd::pow(2.f, float_4::load(&inputs[i])).store(&outputs[i]);
+	});
+
+	// After
+	measure("fastExp2(float)", [] {
+		for (int i = 0; i < SIZE; i++) outputs[i] = GControls::fastExp2(inputs[i]);
+	});
+	measure("fastExp2(float_4)", [] {
+		for (int i = 0; i < SIZE; i += 4) GControls::fastExp2(float_4::load(&inputs[i])).store(&outputs[i]);
+	});
+	return 0;
+}
@@ -0,0 +1,153 @@
+//============================================================================================================
+//!
+//! \file tanh.cpp
+//!
+//! \brief Benchmark of the tanh forms tried for the VCF-F1 clipper.
+//!
+//! Not part of the plugin, so it lives outside src/.  Only Rack's inline simd is used, so it builds from the
+//! SDK headers alone:
+//!
+//!     g++ -std=c++11 -O3 -march=nehalem -funsafe-math-optimizations -I$RACK_DIR/include
+//!         -I$RACK_DIR/dep/include bench/tanh.cpp -o tanh && ./tanh
+//!
+//! Each form is timed by throughput (independent lanes, as in a bank of voices) and by latency (a dependent
+//! chain, as in the ladder's feedback), and checked against std::tanh over [-8, 8].
+//!
+//============================================================================================================
+
+#include <rack.hpp>
+#include <smmintrin.h>
+
+#include <chrono>
+#include <cstdio>
+
+using namespace rack;
+using simd::float_4;
+
+//------------------------------------------------------------------------------------------------------------
+//! \brief The forms under test.
+
+// Pade approximant of tanh, as VCF-F1 ships it
+static float_4 padeDiv(float_4 x) {
+	x = simd::clamp(x, -3.f, 3.f);
+	return x * (27 + x * x) / (27 + 9 * x * x);
+}
+
+// The same approximant with the division replaced by an estimated reciprocal and one Newton step
+static float_4 padeRcp(float_4 x) {
+	x = simd::clamp(x, -3.f, 3.f);
+	float_4 q = 27 + 9 * x * x;
+	float_4 r = simd::rcp(q);
+	r = r * (2.f - q * r);
+	return x * (27 + x * x) * r;
+}
+
+// Linear interpolation over 1024 segments, gathered one 8-byte segment per lane
+struct TanhTable {
+	static constexpr int SIZE = 1024;
+	static constexpr float RANGE = 8.0f;
+
+	alignas(16) float segment[SIZE][2];
+
+	TanhTable() {
+		for (int i = 0; i < SIZE; i++) {
+			double y0 = std::tanh((2.0 * i / SIZE - 1.0) * RANGE);
+			double y1 = std::tanh((2.0 * (i + 1) / SIZE - 1.0) * RANGE);
+			segment[i][0] = y0;
+			segment[i][1] = y1 - y0;
+		}
+	}
+
+	const __m64 *load(int i) const {
+		return reinterpret_cast<const __m64 *>(segment[i]);
+	}
+
+	float_4 operator()(float_4 x) const {
+		float_4 p = simd::clamp(x * (SIZE / 2 / RANGE) + SIZE / 2, 0.f, SIZE - 0.001f);
+		__m128i i = _mm_cvttps_epi32(p.v);
+		__m128 s01 = _mm_loadh_pi(_mm_loadl_pi(_mm_setzero_ps(), load(_mm_cvtsi128_si32(i))), load(_mm_extract_epi32(i, 1)));
+		__m128 s23 = _mm_loadh_pi(_mm_loadl_pi(_mm_setzero_ps(), load(_mm_extract_epi32(i, 2))), load(_mm_extract_epi32(i, 3)));
+		float_4 y0 = _mm_shuffle_ps(s01, s23, _MM_SHUFFLE(2, 0, 2, 0));
+		float_4 dy = _mm_shuffle_ps(s01, s23, _MM_SHUFFLE(3, 1, 3, 1));
+		return y0 + dy * (p - float_4(_mm_cvtepi32_ps(i)));
+	}
+};
+
+static const TanhTable tanhTable;
+
+static float_4 table(float_4 x) {
+	return tanhTable(x);
+}
+
+static float_4 stdTanh(float_4 x) {
+	return float_4(std::tanh(x[0]), std::tanh(x[1]), std::tanh(x[2]), std::tanh(x[3]));
+}
+
+//------------------------------------------------------------------------------------------------------------
+//! \brief The measurements.
+
+static constexpr int SIZE   = 4096;  // float_4s per throughput pass, 64 KB, so the inputs stay in L2
+static constexpr int PASSES = 200;
+static constexpr int RUNS   = 15;    // the fastest run is reported
+
+static float_4 inputs[SIZE];
+static volatile float sink;
+
+template <typename F>
+static double maxError(F f) {
+	double error = 0;
+	for (int i = 0; i <= 1 << 20; i += 4) {
+		float_4 x;
+		for (int j = 0; j < 4; j++) x[j] = -8.f + 16.f * (i + j) / (1 << 20);
+		float_4 y = f(x);
+		for (int j = 0; j < 4; j++) error = std::fmax(error, std::fabs(y[j] - std::tanh(double(x[j]))));
+	}
+	return error;
+}
+
+template <typename Body>
+static double best(Body body) {
+	double ns = INFINITY;
+	for (int run = 0; run < RUNS; run++) {
+		auto t0 = std::chrono::steady_clock::now();
+		body();
+		auto t1 = std::chrono::steady_clock::now();
+		ns = std::fmin(ns, std::chrono::duration<double, std::nano>(t1 - t0).count() / (double(SIZE) * PASSES));
+	}
+	return ns;
+}
+
+template <typename F>
+static void measure(const char *name, F f) {
+	double throughput = best([&] {
+		float_4 sum = 0.f;
+		for (int pass = 0; pass < PASSES; pass++) {
+			for (int i = 0; i < SIZE; i++) {
+				float_4 x = inputs[i];
+				asm volatile("" : "+x"(x.v));  // stop the passes being folded into one
+				sum += f(x);
+			}
+		}
+		sink = sum[0] + sum[1] + sum[2] + sum[3];
+	});
+
+	double latency = best([&] {
+		float_4 x = inputs[0];
+		for (int n = 0; n < SIZE * PASSES; n++) x = f(x * 2.5f + 0.1f);  // stays on the curve's knee
+		sink = x[0] + x[1] + x[2] + x[3];
+	});
+
+	std::printf("%-12s  max error %.1e   throughput %5.2f ns   latency %5.2f ns   per float_4\n", name, maxError(f), throughput, latency);
+}
+
+int main() {
+	for (int i = 0; i < SIZE; i++) {
+		for (int j = 0; j < 4; j++) inputs[i][j] = 6.f * ((i * 4 + j) * 0.6180339f - std::floor((i * 4 + j) * 0.6180339f)) - 3.f;
+	}
+
+	measure("Pade (div)", [](float_4 x) {return padeDiv(x);});
+	measure("Pade (rcp)", [](float_4 x) {return padeRcp(x);});
+	measure("table", [](float_4 x) {return table(x);});
+	measure("std::tanh", [](float_4 x) {return stdTanh(x);});
+	return 0;
+}
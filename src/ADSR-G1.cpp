@@ -34,66 +34,168 @@ struct ADSR : GControls::MicroModule {
 		NUM_LIGHTS
 	};
 
-	bool decaying = false;
-	float env = 0.0f;
-	dsp::SchmittTrigger trigger;
+#if GTX__SIMD
+	typedef dsp::TSchmittTrigger<simd::float_4> Trigger;
+#else
+	typedef dsp::SchmittTrigger Trigger;
+#endif
+
+	// Envelope state for all voices (or poly channels), structure-of-arrays, with this sample's gate and
+	// trigger voltages
+	struct Voices
+	{
+		static constexpr std::size_t N = PORT_MAX_CHANNELS;
+
+		GControls::VoiceArray<float, N> env;
+		GControls::VoiceArray<float, N> decaying;  // 0 or 1
+		GControls::VoiceArray<float, N> gate;
+		GControls::VoiceArray<float, N> trig;
+		std::array<Trigger, GControls::groups(N)> trigger;
+	};
+
+	// One exponential segment, env heading for target with the closed-form step of its time constant
+	struct Segment
+	{
+		float multiplier = 1.0f;  // fraction of the distance to target covered each sample
+		float target     = 0.0f;
+
+		void set(float knob, float target, float sampleTime);
+	};
+
+	// The segments every voice shares; the time CVs are bank-wide, so they are remade once per change of a
+	// knob, CV or the sample rate rather than per voice per sample
+	struct Segments
+	{
+		Segment attack;
+		Segment decay;
+		Segment release;
+
+		float attackKnob  = NAN;
+		float decayKnob   = NAN;
+		float sustain     = NAN;
+		float releaseKnob = NAN;
+		float sampleTime  = NAN;
+
+		void update(float attack, float decay, float sustain, float release, float sampleTime);
+	};
+
+	ADSR() : MicroModule(NUM_PARAMS, NUM_INPUTS, NUM_OUTPUTS) {}
+	void control(Segments &segments, float sampleTime);
+	void input(Voices &voices, std::size_t v);
+	void output(const Voices &voices, std::size_t v);
 
-	ADSR() : MicroModule(NUM_PARAMS, NUM_INPUTS, NUM_OUTPUTS, NUM_LIGHTS) {}
-	void step(float s_Time);
+	static void reset(Voices &voices, std::size_t n);
+	template <typename T> static void process(Voices &voices, const Segments &segments, std::size_t k);
 };
 
 
 //============================================================================================================
 
-void ADSR::step(float s_Time) {
-	float attack = clamp(params[ATTACK_INPUT].getValue() + inputs[ATTACK_INPUT].getVoltage() / 10.0f, 0.0f, 1.0f);
+void ADSR::Segment::set(float knob, float target, float sampleTime) {
+	const float log2Base = 14.2877124f;  // log2(20000)
+	const float maxTime = 10.0f;
+
+	this->target = target;
+
+	// Knob all the way down is infinitely fast, a jump straight to target
+	if (knob < 1e-4) {
+		multiplier = 1.0f;
+	}
+	else {
+		float lambda = GControls::fastExp2(log2Base * (1 - knob)) / maxTime;
+		multiplier = -std::expm1(-lambda * sampleTime);  // exact for any sample rate, 1 - e^-x without the cancellation
+	}
+}
+
+void ADSR::Segments::update(float attack, float decay, float sustain, float release, float sampleTime) {
+	bool rate = sampleTime != this->sampleTime;
+
+	if (rate || attack != attackKnob) {
+		this->attack.set(attack, 1.01f, sampleTime);
+		attackKnob = attack;
+	}
+
+	if (rate || decay != decayKnob || sustain != this->sustain) {
+		this->decay.set(decay, sustain, sampleTime);
+		decayKnob = decay;
+		this->sustain = sustain;
+	}
+
+	if (rate || release != releaseKnob) {
+		this->release.set(release, 0.0f, sampleTime);
+		releaseKnob = release;
+	}
+
+	this->sampleTime = sampleTime;
+}
+
+void ADSR::control(Segments &segments, float sampleTime) {
+	float attack = clamp(params[ATTACK_PARAM].getValue() + inputs[ATTACK_INPUT].getVoltage() / 10.0f, 0.0f, 1.0f);
 	float decay = clamp(params[DECAY_PARAM].getValue() + inputs[DECAY_INPUT].getVoltage() / 10.0f, 0.0f, 1.0f);
 	float sustain = clamp(params[SUSTAIN_PARAM].getValue() + inputs[SUSTAIN_INPUT].getVoltage() / 10.0f, 0.0f, 1.0f);
-	float release = clamp(params[RELEASE_PARAM].getValue() + inputs[RELEASE_PARAM].getVoltage() / 10.0f, 0.0f, 1.0f);
+	float release = clamp(params[RELEASE_PARAM].getValue() + inputs[RELEASE_INPUT].getVoltage() / 10.0f, 0.0f, 1.0f);
 
-	// Gate and trigger
-	bool gated = inputs[GATE_INPUT].getVoltage() >= 1.0f;
-	if (trigger.process(inputs[TRIG_INPUT].getVoltage()))
-		decaying = false;
+	segments.update(attack, decay, sustain, release, sampleTime);
+}
 
-	const float base = 20000.0f;
-	const float maxTime = 10.0f;
+void ADSR::input(Voices &voices, std::size_t v) {
+	voices.gate[v] = inputs[GATE_INPUT].getVoltage();
+	voices.trig[v] = inputs[TRIG_INPUT].getVoltage();
+}
 
-	if (gated) {
-		if (decaying) {
-			// Decay
-			if (decay < 1e-4) {
-				env = sustain;
-			}
-			else {
-				env += powf(base, 1 - decay) / maxTime * (sustain - env) * s_Time;
-			}
-		}
-		else {
-			// Attack
-			// Skip ahead if attack is all the way down (infinitely fast)
-			if (attack < 1e-4) {
-				env = 1.0f;
-			}
-			else {
-				env += powf(base, 1 - attack) / maxTime * (1.01f - env) * s_Time;
-			}
-			if (env >= 1.0f) {
-				env = 1.0f;
-				decaying = true;
-			}
-		}
+//! \brief Start channels n and up again from silence, as a new module would, so a lane group they share
+//! with live channels steps them as silent and a channel coming back sees no stale gate or trigger.
+static void resetTrigger(dsp::SchmittTrigger &trigger, std::size_t) {
+	trigger.reset();
+}
+
+static void resetTrigger(dsp::TSchmittTrigger<simd::float_4> &trigger, std::size_t first) {
+	trigger.state = simd::ifelse(simd::float_4(0.0f, 1.0f, 2.0f, 3.0f) >= static_cast<float>(first), simd::float_4::mask(), trigger.state);
+}
+
+void ADSR::reset(Voices &voices, std::size_t n) {
+	for (std::size_t c=n; c<voices.env.size; ++c) {
+		voices.env[c] = 0.0f;
+		voices.decaying[c] = 0.0f;
+		voices.gate[c] = 0.0f;
+		voices.trig[c] = 0.0f;
 	}
-	else {
-		// Release
-		if (release < 1e-4) {
-			env = 0.0f;
-		}
-		else {
-			env += powf(base, 1 - release) / maxTime * (0.0f - env) * s_Time;
-		}
-		decaying = false;
+
+	for (std::size_t g=n / GControls::LANES; g<voices.trigger.size(); ++g) {
+		resetTrigger(voices.trigger[g], g * GControls::LANES < n ? n - g * GControls::LANES : 0);  // the lanes from this one up
 	}
+}
+
+//! \brief Step voice k (T = float) or voices 4k..4k+3 (T = simd::float_4).
+//!
+//! No branches: every lane takes the attack, decay or release segment its stage selects, and the stage
+//! moves on by masks, in the same order the per-voice state machine used, so both builds agree exactly.
+template <typename T>
+void ADSR::process(Voices &voices, const Segments &segments, std::size_t k) {
+	T env = voices.env.load<T>(k);
+	T decaying = voices.decaying.load<T>(k);
+
+	// Gate and trigger; a trigger restarts the attack
+	auto gated = voices.gate.load<T>(k) >= 1.0f;
+	decaying = simd::ifelse(voices.trigger[k].process(voices.trig.load<T>(k)), 0.0f, decaying);
+
+	auto decay = decaying != 0.0f;
+	T multiplier = simd::ifelse(gated, simd::ifelse(decay, segments.decay.multiplier, segments.attack.multiplier), segments.release.multiplier);
+	T target     = simd::ifelse(gated, simd::ifelse(decay, segments.decay.target,     segments.attack.target),     segments.release.target);
+
+	env += multiplier * (target - env);
+
+	// The attack ends at full level; releasing cancels the decay
+	auto full = gated & (decaying == 0.0f) & (env >= 1.0f);
+	env = simd::ifelse(full, 1.0f, env);
+	decaying = simd::ifelse(gated, simd::ifelse(full, 1.0f, decaying), 0.0f);
+
+	voices.env.store(k, env);
+	voices.decaying.store(k, decaying);
+}
+
+void ADSR::output(const Voices &voices, std::size_t v) {
+	float env = voices.env[v];
 
 	outputs[ENVELOPE_OUTPUT].setVoltage(10.0 * env);
 	outputs[INVERTED_OUTPUT].setVoltage(10.0 * (1.0 - env));
@@ -105,6 +207,13 @@ void ADSR::step(float s_Time) {
 struct ADSR_F1 : Module
 {
 	std::array<ADSR, GTX__N> inst;
+	ADSR::Voices voices;    // mono voices
+	ADSR::Voices channels;  // poly channels
+	ADSR::Segments segments;
+
+	// In poly mode the GATE and TRIG bus sockets take one polyphonic cable each and the first OUT and INV OUT
+	// sockets carry all the envelopes; the other outputs are silent
+	GControls::Cables cables;
 
 	ADSR_F1() {
 		config(ADSR::NUM_PARAMS,
@@ -114,6 +223,12 @@ struct ADSR_F1 : Module
 		configParam(ADSR::DECAY_PARAM,   0.0, 1.0, 0.5, "Decay", " ms", LAMBDA_BASE, MIN_TIME * 1000);
 		configParam(ADSR::SUSTAIN_PARAM, 0.0, 1.0, 0.5, "Sustain", "%", 0, 100);
 		configParam(ADSR::RELEASE_PARAM, 0.0, 1.0, 0.5, "Release", " ms", LAMBDA_BASE, MIN_TIME * 1000);
+
+		for (std::size_t i=0; i<GTX__N; ++i)
+		{
+			for (std::size_t p=0; p<ADSR::NUM_PARAMS;  ++p) inst[i].params .bind(p, params[p]);
+			for (std::size_t p=0; p<ADSR::NUM_OUTPUTS; ++p) inst[i].outputs.bind(p, outputs[omap(p, i)]);
+		}
 	}
 
 	static constexpr std::size_t imap(std::size_t port, std::size_t bank)
@@ -129,17 +244,95 @@ struct ADSR_F1 : Module
 
 	void process(const ProcessArgs& args) override
 	{
-		float sample_Time = args.sampleTime;
+		if (cables.poly) processPoly(args.sampleTime); else processMono(args.sampleTime);
+	}
+
+	//--------------------------------------------------------------------------------------------------------
+	//! \brief One envelope per socket, each normalled to the bus socket.
+
+	void processMono(float sampleTime)
+	{
 		for (std::size_t i=0; i<GTX__N; ++i)
 		{
-			for (std::size_t p=0; p<ADSR::NUM_PARAMS;  ++p) inst[i].params[p]  = params[p];
-			for (std::size_t p=0; p<ADSR::NUM_INPUTS;  ++p) inst[i].inputs[p]  = inputs[imap(p, i)].isConnected() ? inputs[imap(p, i)] : inputs[imap(p, GTX__N)];
-			for (std::size_t p=0; p<ADSR::NUM_OUTPUTS; ++p) inst[i].outputs[p] = outputs[omap(p, i)];
+			for (std::size_t p=0; p<ADSR::NUM_INPUTS;  ++p) inst[i].inputs.bind(p, inputs[imap(p, i)].isConnected() ? inputs[imap(p, i)] : inputs[imap(p, GTX__N)]);
+
+			inst[i].input(voices, i);
+		}
+
+		inst[0].control(segments, sampleTime);
+
+		for (std::size_t g=0; g<GControls::GROUPS; ++g)
+		{
+			ADSR::process<GControls::Lane>(voices, segments, g);
+		}
+
+		for (std::size_t i=0; i<GTX__N; ++i)
+		{
+			inst[i].output(voices, i);
+		}
+
+		outputs[omap(ADSR::ENVELOPE_OUTPUT, 0)].setChannels(1);
+		outputs[omap(ADSR::INVERTED_OUTPUT, 0)].setChannels(1);
+	}
+
+	//--------------------------------------------------------------------------------------------------------
+	//! \brief One envelope per channel of the gate cable.
+
+	void processPoly(float sampleTime)
+	{
+		Input &gate = inputs[imap(ADSR::GATE_INPUT, GTX__N)];
+		Input &trig = inputs[imap(ADSR::TRIG_INPUT, GTX__N)];
+
+		std::size_t n = std::max(gate.getChannels(), 1);
+
+		for (std::size_t c=0; c<n; ++c)
+		{
+			channels.gate[c] = gate.getVoltage(c);
+			channels.trig[c] = trig.getPolyVoltage(c);  // a mono trigger cable restarts every envelope
+		}
+
+		// Channels dropped since the last sample start again from silence when they come back
+		ADSR::reset(channels, n);
+
+		for (std::size_t p=0; p<ADSR::OFF_INPUTS; ++p) inst[0].inputs.bind(p, inputs[imap(p, 0)]);
 
-			inst[i].step(sample_Time);
+		inst[0].control(segments, sampleTime);
+
+		for (std::size_t g=0; g<GControls::groups(n); ++g)
+		{
+			ADSR::process<GControls::Lane>(channels, segments, g);
+		}
+
+		Output &envelope = outputs[omap(ADSR::ENVELOPE_OUTPUT, 0)];
+		Output &inverted = outputs[omap(ADSR::INVERTED_OUTPUT, 0)];
+
+		envelope.setChannels(n);
+		inverted.setChannels(n);
+		for (std::size_t c=0; c<n; ++c)
+		{
+			float env = channels.env[c];
 
-			for (std::size_t p=0; p<ADSR::NUM_OUTPUTS; ++p) outputs[omap(p, i)].setVoltage(inst[i].outputs[p].value);
+			envelope.setVoltage(10.0 * env, c);
+			inverted.setVoltage(10.0 * (1.0 - env), c);
 		}
+
+		for (std::size_t i=1; i<GTX__N; ++i)
+		{
+			outputs[omap(ADSR::ENVELOPE_OUTPUT, i)].setVoltage(0.0f);
+			outputs[omap(ADSR::INVERTED_OUTPUT, i)].setVoltage(0.0f);
+		}
+	}
+
+	json_t *dataToJson() override
+	{
+		json_t *rootJ = json_object();
+		cables.save(rootJ);
+		return rootJ;
+	}
+
+	void dataFromJson(json_t *rootJ) override
+	{
+		cables.load(rootJ);
 	}
 };
 
@@ -194,6 +387,11 @@ struct GtxWidget : ModuleWidget
 		addInput(createInputCentered<GControls::PortInMed>(Vec(GControls::gx(0), GControls::gy(1)), module, ADSR_F1::imap(ADSR::GATE_INPUT, GTX__N)));
 		addInput(createInputCentered<GControls::PortInMed>(Vec(GControls::gx(0), GControls::gy(2)), module, ADSR_F1::imap(ADSR::TRIG_INPUT, GTX__N)));
 	}
+
+	void appendContextMenu(Menu *menu) override
+	{
+		if (ADSR_F1 *bank = dynamic_cast<ADSR_F1 *>(module)) bank->cables.appendMenu(menu, "Mono (one envelope per socket)");
+	}
 };
 
 
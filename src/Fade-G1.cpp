@@ -37,6 +37,10 @@ struct Fade_G1 : Module
 		NUM_LIGHTS
 	};
 
+	// In poly mode the IN 1 and IN 2 bus sockets take one polyphonic cable each and the first OUT 1 and OUT 2
+	// sockets carry all the channels; the other outputs are silent
+	GControls::Cables cables;
+
 	Fade_G1() {
 		config(NUM_PARAMS, (GTX__N+1) * (NUM_INPUTS  - OFF_INPUTS ) + OFF_INPUTS,(GTX__N  ) * (NUM_OUTPUTS - OFF_OUTPUTS) + OFF_OUTPUTS, NUM_LIGHTS);
 		configParam(BLEND12_PARAM, 0.0f, 1.f, 0.0f, "Fade");
@@ -60,20 +64,79 @@ struct Fade_G1 : Module
 
 		if (inputs[BLEND12_INPUT].isConnected()) blend12 *= clamp(inputs[BLEND12_INPUT].getNormalVoltage(10.0f) / 10.0f, 0.0f, 1.0f);
 
-		for (std::size_t i=0; i<GTX__N; ++i)
+		if (cables.poly)
+		{
+			Input &bus1 = inputs[imap(IN1_INPUT, GTX__N)];
+			Input &bus2 = inputs[imap(IN2_INPUT, GTX__N)];
+
+			int n = std::max(std::max(bus1.getChannels(), bus2.getChannels()), 1);
+
+			outputs[omap(OUT1_OUTPUT, 0)].setChannels(n);
+			outputs[omap(OUT2_OUTPUT, 0)].setChannels(n);
+
+			for (int c=0; c<n; c+=4)
+			{
+				simd::float_4 output1, output2;
+
+				fade<simd::float_4>(GControls::polyVoltageSimd(bus1, c), GControls::polyVoltageSimd(bus2, c), blend12, output1, output2);
+
+				outputs[omap(OUT1_OUTPUT, 0)].setVoltageSimd(output1, c);
+				outputs[omap(OUT2_OUTPUT, 0)].setVoltageSimd(output2, c);
+			}
+
+			for (std::size_t i=1; i<GTX__N; ++i)
+			{
+				outputs[omap(OUT1_OUTPUT, i)].setVoltage(0.0f);
+				outputs[omap(OUT2_OUTPUT, i)].setVoltage(0.0f);
+			}
+		}
+		else
 		{
-			float input1 = inputs[imap(IN1_INPUT, i)].isConnected() ? inputs[imap(IN1_INPUT, i)].getVoltage() : inputs[imap(IN1_INPUT, GTX__N)].getVoltage();
-			float input2 = inputs[imap(IN2_INPUT, i)].isConnected() ? inputs[imap(IN2_INPUT, i)].getVoltage() : inputs[imap(IN2_INPUT, GTX__N)].getVoltage();
+			float bus1 = inputs[imap(IN1_INPUT, GTX__N)].getVoltage();
+			float bus2 = inputs[imap(IN2_INPUT, GTX__N)].getVoltage();
+
+			outputs[omap(OUT1_OUTPUT, 0)].setChannels(1);
+			outputs[omap(OUT2_OUTPUT, 0)].setChannels(1);
+
+			for (std::size_t i=0; i<GTX__N; ++i)
+			{
+				float input1 = GControls::normalled(inputs[imap(IN1_INPUT, i)], bus1);
+				float input2 = GControls::normalled(inputs[imap(IN2_INPUT, i)], bus2);
+				float output1, output2;
 
-			float delta12 = blend12 * (input2 - input1);
+				fade<float>(input1, input2, blend12, output1, output2);
 
-			outputs[omap(OUT1_OUTPUT, i)].setVoltage(input1 + delta12);
-			outputs[omap(OUT2_OUTPUT, i)].setVoltage(input2 - delta12);
+				outputs[omap(OUT1_OUTPUT, i)].setVoltage(output1);
+				outputs[omap(OUT2_OUTPUT, i)].setVoltage(output2);
+			}
 		}
 
 		lights[OUT_1_GREEN].value = lights[OUT_2_RED].value =        blend12;
 		lights[OUT_2_GREEN].value = lights[OUT_1_RED].value = 1.0f - blend12;
 	}
+
+	//--------------------------------------------------------------------------------------------------------
+	//! \brief Fade one voice (T = float) or four poly channels (T = simd::float_4).
+
+	template <typename T> static void fade(T input1, T input2, float blend12, T &output1, T &output2)
+	{
+		T delta12 = blend12 * (input2 - input1);
+
+		output1 = input1 + delta12;
+		output2 = input2 - delta12;
+	}
+
+	json_t *dataToJson() override
+	{
+		json_t *rootJ = json_object();
+		cables.save(rootJ);
+		return rootJ;
+	}
+
+	void dataFromJson(json_t *rootJ) override
+	{
+		cables.load(rootJ);
+	}
 };
 
 
@@ -133,6 +196,11 @@ struct GtxWidget : ModuleWidget
 			}
 		}
 	}
+
+	void appendContextMenu(Menu *menu) override
+	{
+		if (Fade_G1 *fade = dynamic_cast<Fade_G1 *>(module)) fade->cables.appendMenu(menu);
+	}
 };
 
 
@@ -51,6 +51,17 @@ struct Fade_G2 : Module
 		NUM_LIGHTS
 	};
 
+	// In poly mode the four IN bus sockets take one polyphonic cable each and the first OUT and INV OUT
+	// sockets carry all the channels; the other outputs are silent
+	GControls::Cables cables;
+
+	// With no blend CV the blends only move with the knobs, so the lights are remade only when they do; with
+	// a blend CV the lights follow it every LIGHT_DIVISION samples
+	static constexpr uint32_t LIGHT_DIVISION = 16;
+	dsp::ClockDivider lightDivider;
+	float lastBlend12 = NAN;
+	float lastBlendAB = NAN;
+
 	Fade_G2() {
 		config(NUM_PARAMS,
 		(GTX__N+1) * (NUM_INPUTS  - OFF_INPUTS ) + OFF_INPUTS,
@@ -66,6 +77,7 @@ struct Fade_G2 : Module
 		lights[IN_2AQ_GREEN].value = 1.0f;  lights[IN_2AQ_RED].value = 0.0f;
 		lights[IN_2BP_GREEN].value = 1.0f;  lights[IN_2BP_RED].value = 0.0f;
 		lights[IN_2BQ_GREEN].value = 1.0f;  lights[IN_2BQ_RED].value = 0.0f;
+		lightDivider.setDivision(LIGHT_DIVISION);
 	}
 
 	static constexpr std::size_t imap(std::size_t port, std::size_t bank)
@@ -83,36 +95,135 @@ struct Fade_G2 : Module
 		float blend12 = params[BLEND12_PARAM].getValue();
 		float blendAB = params[BLENDAB_PARAM].getValue();
 
-		if (inputs[BLEND12_INPUT].isConnected()) blend12 *= clamp(inputs[BLEND12_INPUT].getNormalVoltage(10.0f) / 10.0f, 0.0f, 1.0f);
-		if (inputs[BLENDAB_INPUT].isConnected()) blendAB *= clamp(inputs[BLENDAB_INPUT].getNormalVoltage(10.0f) / 10.0f, 0.0f, 1.0f);
+		if (inputs[BLEND12_INPUT].isConnected() || inputs[BLENDAB_INPUT].isConnected())
+		{
+			if (inputs[BLEND12_INPUT].isConnected()) blend12 *= clamp(inputs[BLEND12_INPUT].getNormalVoltage(10.0f) / 10.0f, 0.0f, 1.0f);
+			if (inputs[BLENDAB_INPUT].isConnected()) blendAB *= clamp(inputs[BLENDAB_INPUT].getNormalVoltage(10.0f) / 10.0f, 0.0f, 1.0f);
+
+			if (lightDivider.process()) setLights(blend12, blendAB);
+
+			lastBlend12 = NAN;  // unplugging the CV must relight
+		}
+		else if (blend12 != lastBlend12 || blendAB != lastBlendAB)
+		{
+			lastBlend12 = blend12;
+			lastBlendAB = blendAB;
+			setLights(blend12, blendAB);
+		}
+
+		if (cables.poly)
+		{
+			processPoly(blend12, blendAB);
+		}
+		else
+		{
+			processMono(blend12, blendAB);
+		}
+	}
+
+	//--------------------------------------------------------------------------------------------------------
+	//! \brief One voice per socket, each normalled to the bus socket.
+
+	void processMono(float blend12, float blendAB)
+	{
+		float bus1A = inputs[imap(IN1A_INPUT, GTX__N)].getVoltage();
+		float bus1B = inputs[imap(IN1B_INPUT, GTX__N)].getVoltage();
+		float bus2A = inputs[imap(IN2A_INPUT, GTX__N)].getVoltage();
+		float bus2B = inputs[imap(IN2B_INPUT, GTX__N)].getVoltage();
+
+		outputs[omap(OUT1A_OUTPUT, 0)].setChannels(1);
+		outputs[omap(OUT2B_OUTPUT, 0)].setChannels(1);
 
 		for (std::size_t i=0; i<GTX__N; ++i)
 		{
-			float input1A  = inputs[imap(IN1A_INPUT, i)].isConnected() ? inputs[imap(IN1A_INPUT, i)].getVoltage() : inputs[imap(IN1A_INPUT, GTX__N)].getVoltage();
-			float input1B  = inputs[imap(IN1B_INPUT, i)].isConnected() ? inputs[imap(IN1B_INPUT, i)].getVoltage() : inputs[imap(IN1B_INPUT, GTX__N)].getVoltage();
-			float input2A  = inputs[imap(IN2A_INPUT, i)].isConnected() ? inputs[imap(IN2A_INPUT, i)].getVoltage() : inputs[imap(IN2A_INPUT, GTX__N)].getVoltage();
-			float input2B  = inputs[imap(IN2B_INPUT, i)].isConnected() ? inputs[imap(IN2B_INPUT, i)].getVoltage() : inputs[imap(IN2B_INPUT, GTX__N)].getVoltage();
+			float input1A = GControls::normalled(inputs[imap(IN1A_INPUT, i)], bus1A);
+			float input1B = GControls::normalled(inputs[imap(IN1B_INPUT, i)], bus1B);
+			float input2A = GControls::normalled(inputs[imap(IN2A_INPUT, i)], bus2A);
+			float input2B = GControls::normalled(inputs[imap(IN2B_INPUT, i)], bus2B);
+			float output1A, output2B;
+
+			fade(input1A, input1B, input2A, input2B, blend12, blendAB, output1A, output2B);
+
+			outputs[omap(OUT1A_OUTPUT, i)].setVoltage(output1A);
+			outputs[omap(OUT2B_OUTPUT, i)].setVoltage(output2B);
+		}
+	}
+
+	//--------------------------------------------------------------------------------------------------------
+	//! \brief One voice per channel of the bus cables, as many as the widest carries.
+
+	void processPoly(float blend12, float blendAB)
+	{
+		Input &bus1A = inputs[imap(IN1A_INPUT, GTX__N)];
+		Input &bus1B = inputs[imap(IN1B_INPUT, GTX__N)];
+		Input &bus2A = inputs[imap(IN2A_INPUT, GTX__N)];
+		Input &bus2B = inputs[imap(IN2B_INPUT, GTX__N)];
+
+		int n = std::max(std::max(std::max(bus1A.getChannels(), bus1B.getChannels()), std::max(bus2A.getChannels(), bus2B.getChannels())), 1);
+
+		outputs[omap(OUT1A_OUTPUT, 0)].setChannels(n);
+		outputs[omap(OUT2B_OUTPUT, 0)].setChannels(n);
 
-			float delta1AB = blendAB * (input1B - input1A);
-			float delta2AB = blendAB * (input2B - input2A);
+		for (int c=0; c<n; c+=4)
+		{
+			simd::float_4 input1A = GControls::polyVoltageSimd(bus1A, c);
+			simd::float_4 input1B = GControls::polyVoltageSimd(bus1B, c);
+			simd::float_4 input2A = GControls::polyVoltageSimd(bus2A, c);
+			simd::float_4 input2B = GControls::polyVoltageSimd(bus2B, c);
+			simd::float_4 output1A, output2B;
 
-			float temp_1A  = input1A + delta1AB;
-			float temp_1B  = input1B - delta1AB;
-			float temp_2A  = input2A + delta2AB;
-			float temp_2B  = input2B - delta2AB;
+			fade(input1A, input1B, input2A, input2B, blend12, blendAB, output1A, output2B);
 
-			float delta12A = blend12 * (temp_2A - temp_1A);
-			float delta12B = blend12 * (temp_2B - temp_1B);
+			outputs[omap(OUT1A_OUTPUT, 0)].setVoltageSimd(output1A, c);
+			outputs[omap(OUT2B_OUTPUT, 0)].setVoltageSimd(output2B, c);
+		}
 
-			outputs[omap(OUT1A_OUTPUT, i)].setVoltage(temp_1A + delta12A);
-			outputs[omap(OUT2B_OUTPUT, i)].setVoltage(temp_2B - delta12B);
+		for (std::size_t i=1; i<GTX__N; ++i)
+		{
+			outputs[omap(OUT1A_OUTPUT, i)].setVoltage(0.0f);
+			outputs[omap(OUT2B_OUTPUT, i)].setVoltage(0.0f);
 		}
+	}
+
+	//--------------------------------------------------------------------------------------------------------
+	//! \brief Fade one voice (T = float) or four poly channels (T = simd::float_4).
+
+	template <typename T> static void fade(T input1A, T input1B, T input2A, T input2B, float blend12, float blendAB, T &output1A, T &output2B)
+	{
+		T delta1AB = blendAB * (input1B - input1A);
+		T delta2AB = blendAB * (input2B - input2A);
+
+		T temp_1A  = input1A + delta1AB;
+		T temp_1B  = input1B - delta1AB;
+		T temp_2A  = input2A + delta2AB;
+		T temp_2B  = input2B - delta2AB;
+
+		T delta12A = blend12 * (temp_2A - temp_1A);
+		T delta12B = blend12 * (temp_2B - temp_1B);
 
+		output1A = temp_1A + delta12A;
+		output2B = temp_2B - delta12B;
+	}
+
+	void setLights(float blend12, float blendAB)
+	{
 		lights[OUT_1AP_GREEN].value = lights[OUT_2BP_RED].value =        blendAB;
 		lights[OUT_1AQ_GREEN].value = lights[OUT_2BQ_RED].value =        blend12;
 		lights[OUT_2BP_GREEN].value = lights[OUT_1AP_RED].value = 1.0f - blendAB;
 		lights[OUT_2BQ_GREEN].value = lights[OUT_1AQ_RED].value = 1.0f - blend12;
 	}
+
+	json_t *dataToJson() override
+	{
+		json_t *rootJ = json_object();
+		cables.save(rootJ);
+		return rootJ;
+	}
+
+	void dataFromJson(json_t *rootJ) override
+	{
+		cables.load(rootJ);
+	}
 };
 
 
@@ -181,6 +292,11 @@ struct GtxWidget : ModuleWidget
 			}
 		}
 	}
+
+	void appendContextMenu(Menu *menu) override
+	{
+		if (Fade_G2 *fade = dynamic_cast<Fade_G2 *>(module)) fade->cables.appendMenu(menu);
+	}
 };
 
 
@@ -6,6 +6,8 @@ void init(rack::Plugin *p)
 {
 	pluginInstance = p;
 
+	GControls::initWavetables();
+
 	p->addModel(modelADSR_F1);
 	p->addModel(modelBinary_G1);
 	p->addModel(modelBlank_03);
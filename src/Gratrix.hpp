@@ -6,6 +6,7 @@
 #include <sstream>
 #include <string>
 #include <cstring>
+#include <cassert>
 #include <array>
 #include <cmath>
 #include <limits>
@@ -17,6 +18,11 @@
 #define GTX__SAVE_SVG   0
 #define GTX__WIDGET()   // do { std::cout << "Gratrix Module : " << __FUNCTION__ << "();" << std::endl; } while(0);
 
+// Run the bank kernels through simd::float_4 lanes (1) or one voice at a time (0)
+#ifndef GTX__SIMD
+#define GTX__SIMD       1
+#endif
+
 using namespace rack;
 
 extern Plugin *pluginInstance;
@@ -43,19 +49,304 @@ extern Model* modelVU_G1;
 
 namespace GControls {
 
+//============================================================================================================
+//! \brief One voice of a bank module.
+//!
+//! Holds pointers into the parent Module's ports rather than copies of them, so the voice DSP code reads
+//! and writes the parent's storage directly.  The bank binds params and outputs once on construction and
+//! re-points each input at either the voice socket or the bus socket when normalising.
+
 struct MicroModule
 {
-	std::vector<Param>  params;
-	std::vector<Input>  inputs;
-	std::vector<Output> outputs;
-	std::vector<Light>  lights;
+	static constexpr std::size_t MAX_PORTS = 8;
+
+	template <typename T> struct Ports
+	{
+		std::array<T *, MAX_PORTS> port = {};
+
+		T &operator [](std::size_t i) const
+		{
+			return *port[i];
+		}
+
+		void bind(std::size_t i, T &that)
+		{
+			port[i] = &that;
+		}
+	};
+
+	Ports<Param>  params;
+	Ports<Input>  inputs;
+	Ports<Output> outputs;
+
+	MicroModule(std::size_t numParams, std::size_t numInputs, std::size_t numOutputs)
+	{
+		assert(numParams <= MAX_PORTS && numInputs <= MAX_PORTS && numOutputs <= MAX_PORTS);
+	}
+};
+
+
+//============================================================================================================
+//! \brief Per-voice state as one contiguous, aligned array indexed by voice (structure-of-arrays).
+//!
+//! The length is rounded up to a whole number of simd::float_4 lanes so a bank may also load and store
+//! four voices at a time; the padding voices are never output.  Flags are held as 0 or 1 in float arrays
+//! so a kernel can load them into lanes and compare them into masks.
+
+template <typename T, std::size_t N = GTX__N> struct alignas(16) VoiceArray
+{
+	static constexpr std::size_t size = (N + 3) / 4 * 4;
+
+	T value[size];
+
+	explicit VoiceArray(const T &init = T())
+	{
+		fill(init);
+	}
+
+	void fill(const T &that)
+	{
+		for (std::size_t i=0; i<size; ++i) value[i] = that;
+	}
+
+	T &operator [](std::size_t i)
+	{
+		return value[i];
+	}
+
+	const T &operator [](std::size_t i) const
+	{
+		return value[i];
+	}
+
+	//! \brief Read voice k (V = float) or lane group k (V = simd::float_4).
+	template <typename V> V load(std::size_t k) const
+	{
+		return load(k, static_cast<V *>(nullptr));
+	}
+
+	//! \brief Write voice k (scalar) or lane group k (simd::float_4).
+	void store(std::size_t k, float         x) { value[k] = x; }
+	void store(std::size_t k, simd::float_4 x) { x.store(&value[4 * k]); }
+
+private:
+
+	float         load(std::size_t k, float         *) const { return value[k]; }
+	simd::float_4 load(std::size_t k, simd::float_4 *) const { return simd::float_4::load(&value[4 * k]); }
+};
+
+
+//============================================================================================================
+//! \brief The type the bank kernels run in, LANES voices at a time, and the lane groups that covers.
+
+#if GTX__SIMD
+typedef simd::float_4 Lane;
+constexpr std::size_t LANES = 4;
+#else
+typedef float Lane;
+constexpr std::size_t LANES = 1;
+#endif
+
+constexpr std::size_t groups(std::size_t n)
+{
+	return (n + LANES - 1) / LANES;
+}
+
+constexpr std::size_t GROUPS = groups(GTX__N);
+
+
+//============================================================================================================
+//! \brief A voice socket, or the bus voltage it is normalled to while unplugged, picked without a branch.
+
+inline float normalled(Input &voice, float bus)
+{
+	return simd::ifelse(voice.isConnected(), voice.getVoltage(), bus);
+}
+
+
+//============================================================================================================
+//! \brief Channels c to c+3 of a polyphonic input, each as getPolyVoltage() reads it: a mono cable feeds every
+//! channel, and channels the cable does not carry are 0 V rather than whatever was left in the socket.
+
+inline simd::float_4 polyVoltageSimd(Input &input, int c)
+{
+	int channels = input.getChannels();
+
+	if (channels == 1) return simd::float_4(input.getVoltage());
+
+	simd::float_4 carried = (simd::float_4(0.0f, 1.0f, 2.0f, 3.0f) + float(c)) < float(channels);
+	return simd::ifelse(carried, input.getVoltageSimd<simd::float_4>(c), 0.0f);
+}
+
+
+//============================================================================================================
+//! \brief A bank's "Cables" choice: one voice per socket, or polyphonic cables into the bus sockets with every
+//! channel out of the first output sockets.  Saved with the patch as "poly".
+
+struct Cables
+{
+	bool poly = false;
 
-	MicroModule(int numParams, int numInputs, int numOutputs, int numLights = 0)
+	void save(json_t *rootJ) const
 	{
-		params.resize(numParams);
-		inputs.resize(numInputs);
-		outputs.resize(numOutputs);
-		lights.resize(numLights);
+		json_object_set_new(rootJ, "poly", json_boolean(poly));
+	}
+
+	void load(json_t *rootJ)
+	{
+		if (json_t *polyJ = json_object_get(rootJ, "poly"))
+		{
+			poly = json_is_true(polyJ);
+		}
+	}
+
+	void appendMenu(Menu *menu, const std::string &mono = "Mono (one voice per socket)")
+	{
+		struct PolyItem : MenuItem
+		{
+			Cables *cables;
+			bool poly;
+			void onAction(const event::Action &e) override { cables->poly = poly; }
+		};
+
+		auto add = [&](std::string text, bool poly)
+		{
+			PolyItem *item = createMenuItem<PolyItem>(text, CHECKMARK(this->poly == poly));
+			item->cables = this;
+			item->poly = poly;
+			menu->addChild(item);
+		};
+
+		menu->addChild(new MenuSeparator);
+		menu->addChild(createMenuLabel("Cables"));
+		add(mono, false);
+		add("Polyphonic (bus sockets, up to 16 channels)", true);
+	}
+};
+
+
+//============================================================================================================
+//! \brief Fast 2^x for float and simd::float_4, relative error about 1.6e-7 (~0.0003 cents); see bench/exp2.cpp.
+//!
+//! The integer part of x goes straight into the exponent field and a degree-5 minimax polynomial covers
+//! the fraction.  x is clamped to the normal float range.
+
+template <typename T> T fastExp2Fraction(T f)
+{
+	return 9.9999994e-1f + f * (6.9315308e-1f + f * (2.4015361e-1f + f * (5.5826318e-2f + f * (8.9893397e-3f + f * 1.8775767e-3f))));
+}
+
+inline float fastExp2(float x)
+{
+	x = std::max(std::min(x, 126.0f), -126.0f);  // not clamp(), which calls fminf/fmaxf
+
+	float   xi   = std::floor(x);
+	int32_t bits = (static_cast<int32_t>(xi) + 127) << 23;
+	float   scale;
+	std::memcpy(&scale, &bits, sizeof(scale));
+
+	return scale * fastExp2Fraction(x - xi);
+}
+
+inline simd::float_4 fastExp2(simd::float_4 x)
+{
+	x = simd::clamp(x, -126.0f, 126.0f);
+
+	simd::float_4 xi   = simd::floor(x);
+	__m128i       bits = _mm_slli_epi32(_mm_add_epi32(_mm_cvttps_epi32(xi.v), _mm_set1_epi32(127)), 23);
+
+	return simd::float_4(_mm_castsi128_ps(bits)) * fastExp2Fraction(x - xi);
+}
+
+//! \brief Frequency in Hz of a 1 V/octave pitch, 0 V being C4.
+template <typename T> T voltToFreq(T volts)
+{
+	return dsp::FREQ_C4 * fastExp2(volts);
+}
+
+
+//============================================================================================================
+//! \brief Per-voice noise, an xorshift32 generator for each voice, for float and simd::float_4.
+//!
+//! Every voice has its own stream, so a lane group draws four values with a handful of integer
+//! instructions and no shared state.  The streams follow from one seed, Rack's RNG by default, so a render
+//! can be repeated by seeding with a constant.  normal() sums four uniforms, a unit variance bell
+//! that stops at +/-3.46, plenty for drift and bootstrap noise.
+
+struct Noise
+{
+	VoiceArray<uint32_t> state;
+
+	explicit Noise(uint32_t seed = random::u32())
+	{
+		this->seed(seed);
+	}
+
+	void seed(uint32_t seed)
+	{
+		for (std::size_t v=0; v<state.size; ++v)
+		{
+			// Spread the seed over the voices (the murmur3 finaliser); xorshift must not start at zero
+			uint32_t z = seed + 0x9E3779B9u * static_cast<uint32_t>(v + 1);
+			z = (z ^ (z >> 16)) * 0x85EBCA6Bu;
+			z = (z ^ (z >> 13)) * 0xC2B2AE35u;
+			z =  z ^ (z >> 16);
+			state[v] = z ? z : 1;
+		}
+	}
+
+	//! \brief Uniform in [-1, 1) for voice k (V = float) or lane group k (V = simd::float_4).
+	template <typename V> V uniform(std::size_t k)
+	{
+		return uniform(k, static_cast<V *>(nullptr));
+	}
+
+	//! \brief Unit variance, zero mean, for voice k (V = float) or lane group k (V = simd::float_4).
+	template <typename V> V normal(std::size_t k)
+	{
+		V sum = uniform<V>(k) + uniform<V>(k) + uniform<V>(k) + uniform<V>(k);
+		return sum * 0.8660254f;  // sqrt(3) / 2, a [-1, 1) uniform having variance 1/3
+	}
+
+	//! \brief A block of scale * uniform() for every voice at once.
+	void uniform(VoiceArray<float> &out, float scale = 1.0f)
+	{
+		for (std::size_t g=0; g<state.size/4; ++g) out.store(g, scale * uniform<simd::float_4>(g));
+	}
+
+	//! \brief A block of scale * normal() for every voice at once.
+	void normal(VoiceArray<float> &out, float scale = 1.0f)
+	{
+		for (std::size_t g=0; g<state.size/4; ++g) out.store(g, scale * normal<simd::float_4>(g));
+	}
+
+private:
+
+	float uniform(std::size_t k, float *)
+	{
+		uint32_t x = state[k];
+		x ^= x << 13;
+		x ^= x >> 17;
+		x ^= x << 5;
+		state[k] = x;
+
+		uint32_t bits = (x >> 9) | 0x3F800000u;  // [1, 2)
+		float    f;
+		std::memcpy(&f, &bits, sizeof(f));
+		return 2.0f * f - 3.0f;
+	}
+
+	simd::float_4 uniform(std::size_t k, simd::float_4 *)
+	{
+		__m128i *p = reinterpret_cast<__m128i *>(&state[4 * k]);
+		__m128i  x = _mm_load_si128(p);
+		x = _mm_xor_si128(x, _mm_slli_epi32(x, 13));
+		x = _mm_xor_si128(x, _mm_srli_epi32(x, 17));
+		x = _mm_xor_si128(x, _mm_slli_epi32(x, 5));
+		_mm_store_si128(p, x);
+
+		simd::float_4 f = _mm_castsi128_ps(_mm_or_si128(_mm_srli_epi32(x, 9), _mm_set1_epi32(0x3F800000)));
+		return 2.0f * f - 3.0f;
 	}
 };
 
@@ -91,6 +382,196 @@ template <typename T> struct Cache
 };
 
 
+//============================================================================================================
+//! \brief Gain ramp for swapping a processing mode without a click.
+//!
+//! When the target differs from the active mode the gain ramps down to zero, the swap happens, and the gain
+//! ramps back up, so whatever state the new mode starts from is heard only at low level.
+
+template <typename T> struct FadeSwitch
+{
+	T     active;
+	float gain = 1.0f;
+
+	explicit FadeSwitch(const T &init) : active(init)
+	{}
+
+	//! \brief Advance one sample towards target by step; returns true on the sample the swap happens.
+	bool process(const T &target, float step)
+	{
+		if (target != active)
+		{
+			gain -= step;
+
+			if (gain <= 0.0f)
+			{
+				gain   = 0.0f;
+				active = target;
+				return true;
+			}
+		}
+		else if (gain < 1.0f)
+		{
+			gain = std::min(gain + step, 1.0f);
+		}
+
+		return false;
+	}
+};
+
+
+//============================================================================================================
+//! \brief Band-limited copies of a single-cycle waveform, one level per octave.
+//!
+//! Level k keeps the lowest 1024 >> k harmonics of the 2048 sample source.  A read picks its levels from the
+//! phase increment so that no partial lands above Nyquist, crossfading between neighbours so sweeps are
+//! smooth.  The tables are built once by initWavetables() at plugin load.
+
+struct MipTable
+{
+	static constexpr int SIZE   = 2048;
+	static constexpr int LEVELS = 11;
+
+	float level[LEVELS][SIZE + 1];  // one guard sample for interpolating across the wrap
+
+	void build(const float *table);
+
+	//! \brief Fractional level for a phase increment of dp per (oversampled) sample.
+	static float select(float dp)
+	{
+		return clamp(std::log2(dp * SIZE) + 1.0f, 0.0f, LEVELS - 1.0f);
+	}
+
+	static simd::float_4 select(simd::float_4 dp)
+	{
+		simd::float_4 l;
+		for (int k = 0; k < 4; k++) l.s[k] = select(dp.s[k]);
+		return l;
+	}
+
+	//! \brief Read at phase p in [0, 1) from fractional level l.
+	float read(float p, float l) const
+	{
+		int   i = static_cast<int>(l);
+		int   j = std::min(i + 1, LEVELS - 1);
+		float x = p * SIZE;
+
+		return crossfade(interpolateLinear(level[i], x), interpolateLinear(level[j], x), l - i);
+	}
+
+	//! \brief Lane-wise read for the vector kernels.
+	simd::float_4 read(simd::float_4 p, simd::float_4 l) const
+	{
+		simd::float_4 y;
+		for (int k = 0; k < 4; k++) y.s[k] = read(p.s[k], l.s[k]);
+		return y;
+	}
+};
+
+extern MipTable sawMip;
+extern MipTable triMip;
+
+void initWavetables();
+
+
+//============================================================================================================
+//! \brief Half-band lowpass for resampling by two, a Blackman-Harris windowed sinc of 4 TAPS - 1 points.
+//!
+//! Every other point of a half-band kernel is zero bar the centre, which is one half, so of the two
+//! polyphase branches one is a TAPS multiply symmetric FIR and the other a plain delay.
+
+template <int TAPS> struct HalfBandKernel
+{
+	float h[TAPS];  // the nonzero odd points, outermost first, each shared by a symmetric pair
+
+	HalfBandKernel()
+	{
+		double sum = 0.0;
+
+		for (int i = 0; i < TAPS; i++)
+		{
+			int    d = 2 * TAPS - 1 - 2 * i;                        // distance from the centre
+			double x = (2 * i + 1) / (4.0 * TAPS);                  // window position, zero ends just outside
+			double w = 0.35875 - 0.48829 * std::cos(2 * M_PI * x) + 0.14128 * std::cos(4 * M_PI * x) - 0.01168 * std::cos(6 * M_PI * x);
+
+			h[i] = std::sin(M_PI * d / 2) / (M_PI * d) * w;
+			sum += 2 * h[i];
+		}
+
+		for (float &c : h) c *= 0.5 / sum;  // each branch passes half of DC
+	}
+};
+
+//! \brief One sample in, two out, for float or simd::float_4 lanes.  The delay is TAPS - 1/2 input samples.
+template <typename T, int TAPS> struct HalfBandUp
+{
+	HalfBandKernel<TAPS> kernel;
+
+	T   x[4 * TAPS];  // the last 2 TAPS inputs, written twice so each window is contiguous
+	int n = 0;
+
+	HalfBandUp()
+	{
+		reset();
+	}
+
+	void reset()
+	{
+		for (T &s : x) s = 0.0f;
+		n = 0;
+	}
+
+	void process(T in, T out[2])
+	{
+		x[n] = x[n + 2 * TAPS] = in;
+		const T *w = &x[n + 1];  // oldest first
+
+		T y = 0.0f;
+		for (int i = 0; i < TAPS; i++) y += kernel.h[i] * (w[i] + w[2 * TAPS - 1 - i]);
+
+		out[0] = 2.0f * y;
+		out[1] = w[TAPS];  // the centre point, TAPS - 1 inputs back
+
+		if (++n == 2 * TAPS) n = 0;
+	}
+};
+
+//! \brief Two samples in, one out, for float or simd::float_4 lanes.  The delay is TAPS - 1/2 output samples.
+template <typename T, int TAPS> struct HalfBandDown
+{
+	HalfBandKernel<TAPS> kernel;
+
+	T   x[4 * TAPS];  // the last 2 TAPS second inputs of each pair, written twice
+	T   z[4 * TAPS];  // and the first, for the centre point
+	int n = 0;
+
+	HalfBandDown()
+	{
+		reset();
+	}
+
+	void reset()
+	{
+		for (T &s : x) s = 0.0f;
+		for (T &s : z) s = 0.0f;
+		n = 0;
+	}
+
+	T process(const T in[2])
+	{
+		z[n] = z[n + 2 * TAPS] = in[0];
+		x[n] = x[n + 2 * TAPS] = in[1];
+		const T *w = &x[n + 1];
+
+		T y = 0.5f * z[n + 1 + TAPS];
+		for (int i = 0; i < TAPS; i++) y += kernel.h[i] * (w[i] + w[2 * TAPS - 1 - i]);
+
+		if (++n == 2 * TAPS) n = 0;
+		return y;
+	}
+};
+
+
 //============================================================================================================
 //! \name UI Port components
 
@@ -0,0 +1,646 @@
+#ifndef GTX__OSCILLATOR_HPP
+#define GTX__OSCILLATOR_HPP
+
+#include "Gratrix.hpp"
+
+namespace GControls {
+
+//! \brief The naive waveforms, as bits of a mask of those a voice needs.
+enum OscillatorWaves
+{
+	SIN_WAVE  = 1 << 0,
+	TRI_WAVE  = 1 << 1,
+	SAW_WAVE  = 1 << 2,
+	SQR_WAVE  = 1 << 3,
+	ALL_WAVES = 15
+};
+
+
+//============================================================================================================
+//! \brief Two-sample polyBLAMP, the band-limiting correction for a sudden change of slope.
+//!
+//! The correction starts a sample before the corner, so whoever uses it must run its output one sample late.
+
+struct PolyBlamp
+{
+	float buf[2] = {};  // for the sample held back and the newest
+
+	//! \brief A slope change of x per sample at time p in [-1, 0] relative to the newest sample.
+	void insertCorner(float p, float x) {
+		float a = -p;
+		float b = 1.0f + p;
+		buf[0] += x * (a * a * a) * (1.0f / 6.0f);
+		buf[1] += x * (b * b * b) * (1.0f / 6.0f);
+	}
+
+	void reset() {
+		buf[0] = 0.0f;
+		buf[1] = 0.0f;
+	}
+
+	//! \brief The correction for the sample held back.
+	float process() {
+		float v = buf[0];
+		buf[0] = buf[1];
+		buf[1] = 0.0f;
+		return v;
+	}
+};
+
+
+//============================================================================================================
+//! \brief The oscillator engine behind VCO-F1 and VCO-F2, one bank of GTX__N voices.
+//!
+//! Runs oversampled at 1x to 16x and decimated, or at 1x with minBLEP corrected steps and polyBLAMP corrected
+//! corners, one sample late.  What a module hears
+//! is set by the Outputs policy, which the engine derives from so the policy can keep per-voice state:
+//!
+//!   CHANNELS            decimated signals per voice
+//!   QUALITY             decimator filter length
+//!   SQR_CUTOFF          analog square highpass cutoff, as a multiple of the sample time
+//!   mask(v)             waveforms voice v needs, OscillatorWaves bits; a voice needing none sleeps
+//!   live(MASK, c)       constexpr, whether channel c carries anything when MASK is generated
+//!   mix<MASK>(k, w, y)  combine w[sin, tri, saw, sqr] into y[CHANNELS]; k is a voice for float, a lane
+//!                       group for simd::float_4
+
+template <typename Outputs> struct VoltageControlledOscillator : Outputs
+{
+	static constexpr std::size_t VOICES = VoiceArray<float>::size;
+	static constexpr int MAX_OVERSAMPLE = 16;
+	static constexpr int CHANNELS = Outputs::CHANNELS;
+
+	bool analog = false;
+	bool soft = false;
+	int oversample;   // 1, 2, 4, 8 or 16, or 0 for band-limited steps at 1x
+
+	// The engine actually running, faded out and back in around a change of oversample
+	FadeSwitch<int> engine;
+
+	// Per-voice state, structure-of-arrays
+	VoiceArray<float> lastSyncValue;
+	VoiceArray<float> syncValue;
+	VoiceArray<float> phase;
+	VoiceArray<float> freq;
+	VoiceArray<float> pw{0.5f};
+	VoiceArray<float> syncEnabled;    // 0 or 1
+	VoiceArray<float> syncDirection;
+
+	// Decimators for one oversampling factor, indexed [voice][channel]
+	template <int OVERSAMPLE> struct Stage {
+		dsp::Decimator<OVERSAMPLE, Outputs::QUALITY> decimator[GTX__N][CHANNELS];
+
+		void reset() {
+			for (auto &voice : decimator) for (auto &d : voice) d.reset();
+		}
+	};
+
+	// Every factor is instantiated up front, so switching never allocates
+	Stage<1>  x1;
+	Stage<2>  x2;
+	Stage<4>  x4;
+	Stage<8>  x8;
+	Stage<16> x16;
+
+	std::array<dsp::RCFilter, GTX__N> sqrFilter;
+	dsp::TRCFilter<simd::float_4> sqrFilter4[VOICES / 4];
+
+	// Band-limited mode, steps corrected by minBLEPs and slope changes by polyBLAMPs per waveform before mixing
+	std::array<dsp::MinBlepGenerator<16, 16>, GTX__N> sinBlep;
+	std::array<dsp::MinBlepGenerator<16, 16>, GTX__N> triBlep;
+	std::array<dsp::MinBlepGenerator<16, 16>, GTX__N> sawBlep;
+	std::array<dsp::MinBlepGenerator<16, 16>, GTX__N> sqrBlep;
+	std::array<PolyBlamp, GTX__N> sinBlamp;
+	std::array<PolyBlamp, GTX__N> triBlamp;
+	std::array<PolyBlamp, GTX__N> sawBlamp;
+	VoiceArray<float> held[4];  // naive waveforms of the sample held back for the polyBLAMPs
+	VoiceArray<int>   generated;  // OscillatorWaves bits each voice generated last sample
+	VoiceArray<float> value[CHANNELS];
+
+	// For analog detuning effect
+	VoiceArray<float> pitchSlew;
+	VoiceArray<int>   pitchSlewIndex;
+	Noise             noise;
+
+	// Padded to whole lane groups so the kernel can write every lane
+	float buffer[CHANNELS][VOICES][MAX_OVERSAMPLE] = {};
+
+	explicit VoltageControlledOscillator(int oversample) : oversample(oversample), engine(oversample) {}
+
+	void setPitch(std::size_t v, float pitchKnob, float pitchCv) {
+		// Compute frequency
+		float pitch = pitchKnob;
+		if (analog) {
+			// Apply pitch slew
+			const float pitchSlewAmount = 3.0f;
+			pitch += pitchSlew[v] * pitchSlewAmount;
+		}
+		else {
+			// Quantize coarse knob if digital mode
+			pitch = roundf(pitch);
+		}
+		pitch += pitchCv;
+		freq[v] = voltToFreq(pitch / 12.0f);
+	}
+
+	void setPulseWidth(std::size_t v, float pulseWidth) {
+		const float pwMin = 0.01f;
+		pw[v] = clamp(pulseWidth, pwMin, 1.0f - pwMin);
+	}
+
+	//! \brief Advance every voice by one sample.
+	void process(float deltaTime) {
+		// 5 ms each way
+		if (engine.process(oversample, deltaTime / 0.005f)) {
+			switch (engine.active) {
+				case  1: x1 .reset(); break;
+				case  2: x2 .reset(); break;
+				case  4: x4 .reset(); break;
+				case  8: x8 .reset(); break;
+				case 16: x16.reset(); break;
+			}
+			generated.fill(0);  // what the new engine left when it last ran is stale
+		}
+
+		for (std::size_t v = 0; v < GTX__N; v++) drift(v, deltaTime);
+
+		switch (engine.active) {
+			case  0: for (std::size_t v = 0; v < GTX__N; v++) processBlep(v, deltaTime, syncValue[v]); break;
+			case  1: processOversampled<1> (deltaTime); break;
+			case  2: processOversampled<2> (deltaTime); break;
+			case  4: processOversampled<4> (deltaTime); break;
+			case  8: processOversampled<8> (deltaTime); break;
+			case 16: processOversampled<16>(deltaTime); break;
+		}
+	}
+
+	//! \brief Output channel c of voice v for this sample.
+	float out(std::size_t v, int c) {
+		return engine.gain * (engine.active ? decimate(v, c, buffer[c][v]) : value[c][v]);
+	}
+
+private:
+
+	template <int OVERSAMPLE> void processOversampled(float deltaTime) {
+		for (std::size_t g = 0; g < GROUPS; g++) {
+			int mask = 0;
+			for (std::size_t v = LANES * g; v < LANES * g + LANES && v < GTX__N; v++) mask |= this->mask(v);
+			if (mask)
+				(this->*kernel<OVERSAMPLE>(mask))(g, deltaTime);
+			else
+				for (std::size_t v = LANES * g; v < LANES * g + LANES && v < GTX__N; v++) sleep(v);
+
+			// Every lane of a group generates the group's mask, which the kernels read back next sample
+			for (std::size_t v = LANES * g; v < LANES * g + LANES && v < GTX__N; v++) generated[v] = mask;
+		}
+	}
+
+	//! \brief A voice nobody listens to costs nothing; its phase holds and only the sync input is followed, so
+	//! it wakes without a false sync edge.
+	void sleep(std::size_t v) {
+		if (syncEnabled[v]) lastSyncValue[v] = syncValue[v] - 0.01f;
+	}
+
+	//! \brief One lane group (or voice, for the scalar path) generating only the waveforms in MASK.
+	//!
+	//! The two paths agree exactly in analog mode; in digital mode simd::sin() stands in for sinf() and the
+	//! sine output differs by the order of 1e-5 V.
+	template <int OVERSAMPLE, int MASK> void processKernel(std::size_t k, float deltaTime) {
+		process<OVERSAMPLE, MASK>(k, deltaTime, syncValue.load<Lane>(k));
+	}
+
+	typedef void (VoltageControlledOscillator::*Kernel)(std::size_t k, float deltaTime);
+
+	//! \brief The kernel for OVERSAMPLE compiled for a given mask of waveforms.
+	template <int OVERSAMPLE> static Kernel kernel(int mask) {
+		static const Kernel table[ALL_WAVES + 1] = {
+			&VoltageControlledOscillator::processKernel<OVERSAMPLE,  0>,
+			&VoltageControlledOscillator::processKernel<OVERSAMPLE,  1>,
+			&VoltageControlledOscillator::processKernel<OVERSAMPLE,  2>,
+			&VoltageControlledOscillator::processKernel<OVERSAMPLE,  3>,
+			&VoltageControlledOscillator::processKernel<OVERSAMPLE,  4>,
+			&VoltageControlledOscillator::processKernel<OVERSAMPLE,  5>,
+			&VoltageControlledOscillator::processKernel<OVERSAMPLE,  6>,
+			&VoltageControlledOscillator::processKernel<OVERSAMPLE,  7>,
+			&VoltageControlledOscillator::processKernel<OVERSAMPLE,  8>,
+			&VoltageControlledOscillator::processKernel<OVERSAMPLE,  9>,
+			&VoltageControlledOscillator::processKernel<OVERSAMPLE, 10>,
+			&VoltageControlledOscillator::processKernel<OVERSAMPLE, 11>,
+			&VoltageControlledOscillator::processKernel<OVERSAMPLE, 12>,
+			&VoltageControlledOscillator::processKernel<OVERSAMPLE, 13>,
+			&VoltageControlledOscillator::processKernel<OVERSAMPLE, 14>,
+			&VoltageControlledOscillator::processKernel<OVERSAMPLE, 15>
+		};
+		return table[mask & ALL_WAVES];
+	}
+
+	// The square's highpass keeps the same time constant at any oversampling factor
+	static float sqrCutoff(float deltaTime, int oversample) {
+		return Outputs::SQR_CUTOFF * deltaTime / oversample;
+	}
+
+	void drift(std::size_t v, float deltaTime) {
+		if (analog) {
+			// Adjust pitch slew
+			if (++pitchSlewIndex[v] > 32) {
+				const float pitchSlewTau = 100.0f; // Time constant for leaky integrator in seconds
+				pitchSlew[v] += (noise.normal<float>(v) - pitchSlew[v] / pitchSlewTau) * deltaTime;
+				pitchSlewIndex[v] = 0;
+			}
+		}
+	}
+
+	//! \brief Scalar reference path, one voice, generating only the waveforms in MASK.
+	template <int OVERSAMPLE, int MASK> void process(std::size_t v, float deltaTime, float syncValue) {
+		// Advance phase
+		float deltaPhase = clamp(freq[v] * deltaTime, 1e-6, 0.5f);
+
+		// Detect sync
+		int syncIndex = -1; // Index in the oversample loop where sync occurs [0, OVERSAMPLE)
+		float syncCrossing = 0.0f; // Offset that sync occurs [0.0f, 1.0f)
+		if (syncEnabled[v]) {
+			syncValue -= 0.01f;
+			if (syncValue > 0.0f && lastSyncValue[v] <= 0.0f) {
+				float deltaSync = syncValue - lastSyncValue[v];
+				syncCrossing = 1.0f - syncValue / deltaSync;
+				syncCrossing *= OVERSAMPLE;
+				syncIndex = (int)syncCrossing;
+				syncCrossing -= syncIndex;
+			}
+			lastSyncValue[v] = syncValue;
+		}
+
+		// Wavetable level for the analog tri and saw
+		float mip = analog ? MipTable::select(deltaPhase / OVERSAMPLE) : 0.0f;
+
+		if (syncDirection[v])
+			deltaPhase *= -1.0f;
+
+		float p = phase[v];
+
+		// The square's highpass restarts with the square, rather than from where it was left
+		if ((MASK & SQR_WAVE) && !(generated[v] & SQR_WAVE))
+			sqrFilter[v].reset();
+		sqrFilter[v].setCutoff(sqrCutoff(deltaTime, OVERSAMPLE));
+
+		for (int i = 0; i < OVERSAMPLE; i++) {
+			if (syncIndex == i) {
+				if (soft) {
+					syncDirection[v] = !syncDirection[v];
+					deltaPhase *= -1.0f;
+				}
+				else {
+					// p = syncCrossing * deltaPhase / OVERSAMPLE;
+					p = 0.0f;
+				}
+			}
+
+			float w[4] = {};
+			if (MASK & SIN_WAVE) w[0] = sinShape(p);
+			if (MASK & TRI_WAVE) w[1] = triShape(p, mip);
+			if (MASK & SAW_WAVE) w[2] = sawShape(p, mip);
+			if (MASK & SQR_WAVE) {
+				w[3] = sqrShape(p, pw[v]);
+				if (analog) {
+					// Simply filter here
+					sqrFilter[v].process(w[3]);
+					w[3] = 0.71f * sqrFilter[v].highpass();
+				}
+			}
+
+			float y[CHANNELS] = {};
+			this->template mix<MASK>(v, w, y);
+			for (int c = 0; c < CHANNELS; c++)
+				if (Outputs::live(MASK, c))
+					buffer[c][v][i] = y[c];
+
+			// Advance phase
+			p += deltaPhase / OVERSAMPLE;
+			p = eucMod(p, 1.0f);
+		}
+
+		phase[v] = p;
+	}
+
+	//! \brief Vector path, voices 4g..4g+3 in the lanes of a simd::float_4.
+	//!
+	//! Mirrors the scalar path operation for operation; branches on per-voice
+	//! values become lane masks, branches on bank-wide mode flags stay branches.
+	template <int OVERSAMPLE, int MASK> void process(std::size_t g, float deltaTime, simd::float_4 syncValue) {
+		using simd::float_4;
+
+		// Advance phase
+		float_4 deltaPhase = simd::clamp(freq.load<float_4>(g) * deltaTime, 1e-6f, 0.5f);
+
+		// Detect sync, syncIndex is -1 in lanes that do not sync this sample
+		float_4 enabled = syncEnabled.load<float_4>(g) != 0.0f;
+		float_4 lastSync = lastSyncValue.load<float_4>(g);
+		syncValue -= 0.01f;
+		float_4 crossed = enabled & (syncValue > 0.0f) & (lastSync <= 0.0f);
+		float_4 syncCrossing = (1.0f - syncValue / (syncValue - lastSync)) * OVERSAMPLE;
+		float_4 syncIndex = simd::ifelse(crossed, simd::floor(syncCrossing), -1.0f);
+		bool anySync = simd::movemask(crossed);
+		lastSyncValue.store(g, simd::ifelse(enabled, syncValue, lastSync));
+
+		// Wavetable level for the analog tri and saw
+		float_4 mip = analog ? MipTable::select(deltaPhase / OVERSAMPLE) : 0.0f;
+
+		float_4 direction = syncDirection.load<float_4>(g) != 0.0f;
+		deltaPhase = simd::ifelse(direction, -deltaPhase, deltaPhase);
+
+		float_4 p = phase.load<float_4>(g);
+		float_4 pulseWidth = pw.load<float_4>(g);
+
+		if ((MASK & SQR_WAVE) && !(generated[4 * g] & SQR_WAVE))
+			sqrFilter4[g].reset();
+		sqrFilter4[g].setCutoff(sqrCutoff(deltaTime, OVERSAMPLE));
+
+		for (int i = 0; i < OVERSAMPLE; i++) {
+			if (anySync) {
+				float_4 sync = (syncIndex == float_4(i));
+				if (soft) {
+					direction ^= sync;
+					deltaPhase = simd::ifelse(sync, -deltaPhase, deltaPhase);
+				}
+				else {
+					p = simd::ifelse(sync, 0.0f, p);
+				}
+			}
+
+			float_4 w[4] = {};
+			if (MASK & SIN_WAVE) w[0] = sinShape(p);
+			if (MASK & TRI_WAVE) w[1] = triShape(p, mip);
+			if (MASK & SAW_WAVE) w[2] = sawShape(p, mip);
+			if (MASK & SQR_WAVE) {
+				w[3] = simd::ifelse(p < pulseWidth, 1.f, -1.f);
+				if (analog) {
+					// Simply filter here
+					sqrFilter4[g].process(w[3]);
+					w[3] = 0.71f * sqrFilter4[g].highpass();
+				}
+			}
+
+			float_4 y[CHANNELS] = {};
+			this->template mix<MASK>(g, w, y);
+			for (int c = 0; c < CHANNELS; c++)
+				if (Outputs::live(MASK, c))
+					for (std::size_t l = 0; l < 4; l++) buffer[c][4 * g + l][i] = y[c].s[l];
+
+			// Advance phase, p - floor(p) is eucMod(p, 1) for the range p stays in
+			p += deltaPhase / OVERSAMPLE;
+			p -= simd::floor(p);
+		}
+
+		phase.store(g, p);
+		syncDirection.store(g, simd::ifelse(direction, 1.0f, 0.0f));
+	}
+
+	//! \brief Band-limited path, one voice at the sample rate.
+	//!
+	//! The naive waveforms are evaluated once per sample and every step in
+	//! them (saw and square edges, hard sync) is corrected with a minBLEP
+	//! inserted at its exact sub-sample time. In digital mode every change
+	//! of slope (triangle corners, sync) is corrected with a polyBLAMP,
+	//! which reaches back a sample, so the output is the sample before.
+	void processBlep(std::size_t v, float deltaTime, float syncValue) {
+		int mask = this->mask(v);
+		int starting = mask & ~generated[v];
+		generated[v] = mask;
+
+		if (!mask) {
+			sleep(v);
+			return;
+		}
+
+		// Advance phase
+		float deltaPhase = clamp(freq[v] * deltaTime, 1e-6, 0.5f);
+
+		// Detect sync, as a time relative to this sample (-1, 0]
+		float syncTime = 1.0f;
+		if (syncEnabled[v]) {
+			syncValue -= 0.01f;
+			if (syncValue > 0.0f && lastSyncValue[v] <= 0.0f) {
+				float deltaSync = syncValue - lastSyncValue[v];
+				syncTime = -syncValue / deltaSync;
+			}
+			lastSyncValue[v] = syncValue;
+		}
+
+		float mip = analog ? MipTable::select(deltaPhase) : 0.0f;
+
+		if (starting)
+			restart(v, starting, mip);
+
+		if (syncDirection[v])
+			deltaPhase *= -1.0f;
+
+		// The sample held back, with the steps up to it, before any step of this one is inserted
+		float w[4] = {};
+		if (mask & SIN_WAVE) w[0] = held[0][v] + sinBlep[v].process();
+		if (mask & TRI_WAVE) w[1] = held[1][v] + triBlep[v].process();
+		if (mask & SAW_WAVE) w[2] = held[2][v] + sawBlep[v].process();
+		if (mask & SQR_WAVE) w[3] = held[3][v] + sqrBlep[v].process();
+
+		float p = phase[v];
+		float t = -1.0f;
+
+		if (syncTime <= 0.0f) {
+			float q = p + deltaPhase * (syncTime - t);
+			float r = eucMod(q, 1.0f);
+			edges(v, mask, p, q, t, syncTime, deltaPhase);
+			if (soft) {
+				// Every slope reverses
+				if (!analog) {
+					if (mask & SIN_WAVE) sinBlamp[v].insertCorner(syncTime, -2.0f * sinSlope(r) * deltaPhase);
+					if (mask & TRI_WAVE) triBlamp[v].insertCorner(syncTime, -2.0f * triSlope(r) * deltaPhase);
+					if (mask & SAW_WAVE) sawBlamp[v].insertCorner(syncTime, -2.0f * sawSlope() * deltaPhase);
+				}
+				syncDirection[v] = !syncDirection[v];
+				deltaPhase *= -1.0f;
+				p = q;
+			}
+			else {
+				if (mask & SIN_WAVE) sinBlep[v].insertDiscontinuity(syncTime, sinShape(0.0f) - sinShape(r));
+				if (mask & TRI_WAVE) triBlep[v].insertDiscontinuity(syncTime, triShape(0.0f, mip) - triShape(r, mip));
+				if (mask & SAW_WAVE) sawBlep[v].insertDiscontinuity(syncTime, sawShape(0.0f, mip) - sawShape(r, mip));
+				if (mask & SQR_WAVE) sqrBlep[v].insertDiscontinuity(syncTime, sqrShape(0.0f, pw[v]) - sqrShape(r, pw[v]));
+				if (!analog) {
+					if (mask & SIN_WAVE) sinBlamp[v].insertCorner(syncTime, (sinSlope(0.0f) - sinSlope(r)) * deltaPhase);
+					if (mask & TRI_WAVE) triBlamp[v].insertCorner(syncTime, (triSlope(0.0f) - triSlope(r)) * deltaPhase);
+				}
+				p = 0.0f;
+			}
+			t = syncTime;
+		}
+
+		float q = p - deltaPhase * t;
+		edges(v, mask, p, q, t, 0.0f, deltaPhase);
+		p = eucMod(q, 1.0f);
+		phase[v] = p;
+
+		// This sample is held back, and the slope changes up to it have now all reached the one going out
+		if (mask & SIN_WAVE) {
+			held[0][v] = sinShape(p);
+			w[0] += sinBlamp[v].process();
+		}
+		if (mask & TRI_WAVE) {
+			held[1][v] = triShape(p, mip);
+			w[1] += triBlamp[v].process();
+		}
+		if (mask & SAW_WAVE) {
+			held[2][v] = sawShape(p, mip);
+			w[2] += sawBlamp[v].process();
+		}
+		if (mask & SQR_WAVE) {
+			held[3][v] = sqrShape(p, pw[v]);
+			if (analog) {
+				sqrFilter[v].setCutoff(sqrCutoff(deltaTime, 1));
+				sqrFilter[v].process(w[3]);
+				w[3] = 0.71f * sqrFilter[v].highpass();
+			}
+		}
+
+		float y[CHANNELS] = {};
+		this->template mix<ALL_WAVES>(v, w, y);
+		for (int c = 0; c < CHANNELS; c++) value[c][v] = y[c];
+	}
+
+	//! \brief Start the waveforms in mask on voice v afresh: the sample held back is taken at the phase now and
+	//! the corrections pending since it last generated them are dropped, rather than replayed as a stale step,
+	//! and the square's highpass starts from rest.
+	void restart(std::size_t v, int mask, float mip) {
+		auto clear = [](dsp::MinBlepGenerator<16, 16> &minBlep) {
+			std::fill(std::begin(minBlep.buf), std::end(minBlep.buf), 0.0f);
+		};
+
+		float p = phase[v];
+		if (mask & SIN_WAVE) {
+			held[0][v] = sinShape(p);
+			clear(sinBlep[v]);
+			sinBlamp[v].reset();
+		}
+		if (mask & TRI_WAVE) {
+			held[1][v] = triShape(p, mip);
+			clear(triBlep[v]);
+			triBlamp[v].reset();
+		}
+		if (mask & SAW_WAVE) {
+			held[2][v] = sawShape(p, mip);
+			clear(sawBlep[v]);
+			sawBlamp[v].reset();
+		}
+		if (mask & SQR_WAVE) {
+			held[3][v] = sqrShape(p, pw[v]);
+			clear(sqrBlep[v]);
+			sqrFilter[v].reset();
+		}
+	}
+
+	//! \brief Insert the saw and square steps and the triangle corners crossed while the phase runs a -> b
+	//! (unwrapped) over times t0 -> t1, deltaPhase a sample.
+	void edges(std::size_t v, int mask, float a, float b, float t0, float t1, float deltaPhase) {
+		if (!analog && (mask & SAW_WAVE)) {
+			edge(sawBlep[v], a, b, t0, t1, 0.5f, -2.0f);
+		}
+		if (!analog && (mask & TRI_WAVE)) {
+			corner(triBlamp[v], a, b, t0, t1, 0.25f, -8.0f * std::fabs(deltaPhase));
+			corner(triBlamp[v], a, b, t0, t1, 0.75f,  8.0f * std::fabs(deltaPhase));
+		}
+		if (mask & SQR_WAVE) {
+			edge(sqrBlep[v], a, b, t0, t1, 0.0f,  2.0f);
+			edge(sqrBlep[v], a, b, t0, t1, pw[v], -2.0f);
+		}
+	}
+
+	//! \brief The time the phase running a -> b over t0 -> t1 crosses phase "at" (mod 1), if it does.
+	static bool crossing(float a, float b, float t0, float t1, float at, float &time) {
+		float lo = std::min(a, b);
+		float hi = std::max(a, b);
+		float e = at + std::floor(hi - at);
+		if (e > lo) {
+			time = t0 + (t1 - t0) * (e - a) / (b - a);
+			return true;
+		}
+		return false;
+	}
+
+	//! \brief A step of height x at phase "at" (mod 1), negated when the phase runs backwards.
+	static void edge(dsp::MinBlepGenerator<16, 16> &minBlep, float a, float b, float t0, float t1, float at, float x) {
+		float time;
+		if (crossing(a, b, t0, t1, at, time)) {
+			minBlep.insertDiscontinuity(time, (b > a) ? x : -x);
+		}
+	}
+
+	//! \brief A slope change of x per sample at phase "at" (mod 1), the same whichever way the phase runs.
+	static void corner(PolyBlamp &polyBlamp, float a, float b, float t0, float t1, float at, float x) {
+		float time;
+		if (crossing(a, b, t0, t1, at, time)) {
+			polyBlamp.insertCorner(time, x);
+		}
+	}
+
+	// Naive waveforms, scalar and four voices at a time
+	float sinShape(float p) const {
+		if (analog)
+			// Quadratic approximation of sine, slightly richer harmonics
+			return 1.08f * ((p < 0.5f) ? 1.f - 16.f * powf(p - 0.25f, 2) : -1.f + 16.f * powf(p - 0.75f, 2));
+		return sinf(2.f*M_PI * p);
+	}
+	float triShape(float p, float mip) const {
+		if (analog)
+			return 1.25f * triMip.read(p, mip);
+		return (p < 0.25f) ? 4.f * p : (p < 0.75f) ? 2.f - 4.f * p : -4.f + 4.f * p;
+	}
+	float sawShape(float p, float mip) const {
+		if (analog)
+			return 1.66f * sawMip.read(p, mip);
+		return (p < 0.5f) ? 2.f * p : -2.f + 2.f * p;
+	}
+	static float sqrShape(float p, float pw) {
+		return (p < pw) ? 1.f : -1.f;
+	}
+
+	// Slopes of the digital waveforms per unit of phase, for the polyBLAMPs
+	static float sinSlope(float p) {
+		return 2.f*M_PI * cosf(2.f*M_PI * p);
+	}
+	static float triSlope(float p) {
+		return (p < 0.25f || p >= 0.75f) ? 4.f : -4.f;
+	}
+	static float sawSlope() {
+		return 2.f;
+	}
+
+	simd::float_4 sinShape(simd::float_4 p) const {
+		if (analog) {
+			simd::float_4 a = p - 0.25f;
+			simd::float_4 b = p - 0.75f;
+			return 1.08f * simd::ifelse(p < 0.5f, 1.f - 16.f * (a * a), -1.f + 16.f * (b * b));
+		}
+		return simd::sin(simd::float_4(2.f*M_PI) * p);
+	}
+	simd::float_4 triShape(simd::float_4 p, simd::float_4 mip) const {
+		if (analog)
+			return 1.25f * triMip.read(p, mip);
+		return simd::ifelse(p < 0.25f, 4.f * p, simd::ifelse(p < 0.75f, 2.f - 4.f * p, -4.f + 4.f * p));
+	}
+	simd::float_4 sawShape(simd::float_4 p, simd::float_4 mip) const {
+		if (analog)
+			return 1.66f * sawMip.read(p, mip);
+		return simd::ifelse(p < 0.5f, 2.f * p, -2.f + 2.f * p);
+	}
+
+	float decimate(std::size_t v, int c, float *in) {
+		switch (engine.active) {
+			case  1: return x1 .decimator[v][c].process(in);
+			case  2: return x2 .decimator[v][c].process(in);
+			case  4: return x4 .decimator[v][c].process(in);
+			case  8: return x8 .decimator[v][c].process(in);
+			default: return x16.decimator[v][c].process(in);
+		}
+	}
+};
+
+} // GControls
+
+#endif
@@ -68,7 +68,7 @@ struct Scope : Module {
 		external = params[EXTERNAL_PARAM].getValue() <= 0.0f;
 
 		// Compute time
-		float deltaTime = powf(2.0f, params[TIME_PARAM].getValue());
+		float deltaTime = GControls::fastExp2(params[TIME_PARAM].getValue());
 		float sample_Rate = args.sampleRate;
 		int frameCount = (int)ceilf(deltaTime * sample_Rate);
 
@@ -324,7 +324,7 @@ struct Seq_G1 : Module {
 			else
 			{
 				// Internal clock
-				float clockTime = powf(2.0f, params[CLOCK_PARAM].getValue() + inputs[CLOCK_INPUT].getVoltage());
+				float clockTime = GControls::fastExp2(params[CLOCK_PARAM].getValue() + inputs[CLOCK_INPUT].getVoltage());
 				phase += clockTime * APP->engine->getSampleTime();
 
 				if (phase >= 1.0f)
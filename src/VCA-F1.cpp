@@ -24,21 +24,56 @@ struct VCA : GControls::MicroModule {
 		OFF_OUTPUTS = OUT_OUTPUT
 	};
 
+	// Per-voice (or per-channel) inputs, and the outputs made from them several voices at a time; the lanes
+	// past the last voice keep a zero input so they add nothing to the mix
+	struct Controls {
+		static constexpr std::size_t N = PORT_MAX_CHANNELS;
+
+		GControls::VoiceArray<float, N> input;
+		GControls::VoiceArray<float, N> lin;
+		GControls::VoiceArray<float, N> exp;
+		GControls::VoiceArray<float, N> linConnected;  // 0 or 1
+		GControls::VoiceArray<float, N> expConnected;
+		GControls::VoiceArray<float, N> output;
+	};
+
 	VCA() : MicroModule(NUM_PARAMS, NUM_INPUTS, NUM_OUTPUTS) {}
-	void step();
+	void control(Controls &controls, std::size_t v);
+	void output(const Controls &controls, std::size_t v);
+
+	template <typename T> static T process(Controls &controls, std::size_t k, float level);
 };
 
 
 //============================================================================================================
 
-void VCA::step() {
-	float v = inputs[IN_INPUT].getVoltage() * params[LEVEL_PARAM].getValue();
-	if (inputs[LIN_INPUT].isConnected())
-		v *= clamp(inputs[LIN_INPUT].getVoltage() / 10.0f, 0.0f, 1.0f);
+void VCA::control(Controls &controls, std::size_t v) {
+	controls.input[v] = inputs[IN_INPUT].getVoltage();
+	controls.lin[v] = inputs[LIN_INPUT].getVoltage();
+	controls.exp[v] = inputs[EXP_INPUT].getVoltage();
+	controls.linConnected[v] = inputs[LIN_INPUT].isConnected();
+	controls.expConnected[v] = inputs[EXP_INPUT].isConnected();
+}
+
+//! \brief Output of voice k (T = float) or voices 4k..4k+3 (T = simd::float_4), returned for the mix.
+template <typename T>
+T VCA::process(Controls &controls, std::size_t k, float level) {
 	const float expBase = 50.0f;
-	if (inputs[EXP_INPUT].isConnected())
-		v *= rescale(powf(expBase, clamp(inputs[EXP_INPUT].getVoltage() / 10.0f, 0.0f, 1.0f)), 1.0f, expBase, 0.0f, 1.0f);
-	outputs[OUT_OUTPUT].setVoltage(v);
+	const float log2ExpBase = 5.64385619f;  // log2(expBase)
+
+	T lin = simd::clamp(controls.lin.load<T>(k) / 10.0f, 0.0f, 1.0f);
+	T exp = (GControls::fastExp2(log2ExpBase * simd::clamp(controls.exp.load<T>(k) / 10.0f, 0.0f, 1.0f)) - 1.0f) / (expBase - 1.0f);
+
+	T v = controls.input.load<T>(k) * level;
+	v *= simd::ifelse(controls.linConnected.load<T>(k) != 0.0f, lin, 1.0f);
+	v *= simd::ifelse(controls.expConnected.load<T>(k) != 0.0f, exp, 1.0f);
+
+	controls.output.store(k, v);
+	return v;
+}
+
+void VCA::output(const Controls &controls, std::size_t v) {
+	outputs[OUT_OUTPUT].setVoltage(controls.output[v]);
 }
 
 
@@ -47,6 +82,12 @@ void VCA::step() {
 struct VCABank : Module
 {
 	std::array<VCA, GTX__N> inst;
+	VCA::Controls controls;  // mono voices
+	VCA::Controls channels;  // poly channels
+
+	// In poly mode the EXP, LIN and IN bus sockets take one polyphonic cable each and the first OUT socket
+	// carries all the channels; the other OUT sockets are silent
+	GControls::Cables cables;
 
 	VCABank() {
 		config(VCA::NUM_PARAMS,
@@ -56,6 +97,12 @@ struct VCABank : Module
 		configParam(VCA::MIX_1_PARAM, 0.0f, 1.0f, 0.5f, "Ch 1 Mix", "%", 0, 100);
 		configParam(VCA::MIX_2_PARAM, 0.0f, 1.0f, 0.5f, "Ch 2 Mix", "%", 0, 100);
 
+		for (std::size_t i=0; i<GTX__N; ++i)
+		{
+			for (std::size_t p=0; p<VCA::NUM_PARAMS;  ++p) inst[i].params .bind(p, params[p]);
+			for (std::size_t p=0; p<VCA::NUM_OUTPUTS; ++p) inst[i].outputs.bind(p, outputs[omap(p, i)]);
+		}
+
 	}
 
 	static constexpr std::size_t imap(std::size_t port, std::size_t bank)
@@ -69,27 +116,113 @@ struct VCABank : Module
 	}
 
 	void process(const ProcessArgs& args) override
+	{
+		float mix = cables.poly ? processPoly() : processMono();
+
+		outputs[VCA::MIX_1_OUTPUT].setVoltage(mix * params[VCA::MIX_1_PARAM].getValue());
+		outputs[VCA::MIX_2_OUTPUT].setVoltage(mix * params[VCA::MIX_2_PARAM].getValue());
+	}
+
+	//--------------------------------------------------------------------------------------------------------
+	//! \brief One voice per socket, each normalled to the bus socket; returns the mix.
+
+	float processMono()
 	{
 		for (std::size_t i=0; i<GTX__N; ++i)
 		{
-			for (std::size_t p=0; p<VCA::NUM_PARAMS;  ++p) inst[i].params[p]  = params[p];
-			for (std::size_t p=0; p<VCA::NUM_INPUTS;  ++p) inst[i].inputs[p]  = inputs[imap(p, i)].isConnected() ? inputs[imap(p, i)] : inputs[imap(p, GTX__N)];
-			for (std::size_t p=0; p<VCA::NUM_OUTPUTS; ++p) inst[i].outputs[p] = outputs[omap(p, i)];
+			for (std::size_t p=0; p<VCA::NUM_INPUTS;  ++p) inst[i].inputs.bind(p, inputs[imap(p, i)].isConnected() ? inputs[imap(p, i)] : inputs[imap(p, GTX__N)]);
 
-			inst[i].step();
-
-			for (std::size_t p=0; p<VCA::NUM_OUTPUTS; ++p) outputs[omap(p, i)].setVoltage(inst[i].outputs[p].value);
+			inst[i].control(controls, i);
 		}
 
-		float mix = 0.0f;
+		float level = params[VCA::LEVEL_PARAM].getValue();
+		GControls::Lane sum = 0.0f;
+
+		for (std::size_t g=0; g<GControls::GROUPS; ++g)
+		{
+			sum += VCA::process<GControls::Lane>(controls, g, level);
+		}
 
 		for (std::size_t i=0; i<GTX__N; ++i)
 		{
-			mix += inst[i].outputs[VCA::OUT_OUTPUT].value;
+			inst[i].output(controls, i);
 		}
 
-		outputs[VCA::MIX_1_OUTPUT].setVoltage(mix * params[VCA::MIX_1_PARAM].getValue());
-		outputs[VCA::MIX_2_OUTPUT].setVoltage(mix * params[VCA::MIX_2_PARAM].getValue());
+		outputs[omap(VCA::OUT_OUTPUT, 0)].setChannels(1);
+
+		return hsum(sum);
+	}
+
+	//--------------------------------------------------------------------------------------------------------
+	//! \brief One voice per channel of the bus cables, as many as IN carries; returns the mix.
+
+	float processPoly()
+	{
+		Input &exp = inputs[imap(VCA::EXP_INPUT, GTX__N)];
+		Input &lin = inputs[imap(VCA::LIN_INPUT, GTX__N)];
+		Input &in  = inputs[imap(VCA::IN_INPUT,  GTX__N)];
+
+		std::size_t n = std::max(in.getChannels(), 1);
+
+		for (std::size_t c=0; c<n; ++c)
+		{
+			channels.input[c] = in.getVoltage(c);
+			channels.lin[c] = lin.getPolyVoltage(c);  // a mono CV cable drives every channel
+			channels.exp[c] = exp.getPolyVoltage(c);
+			channels.linConnected[c] = lin.isConnected();
+			channels.expConnected[c] = exp.isConnected();
+		}
+
+		// Channels dropped since the last sample must not reach the mix
+		for (std::size_t c=n; c<channels.input.size; ++c)
+		{
+			channels.input[c] = 0.0f;
+		}
+
+		float level = params[VCA::LEVEL_PARAM].getValue();
+		GControls::Lane sum = 0.0f;
+
+		for (std::size_t g=0; g<GControls::groups(n); ++g)
+		{
+			sum += VCA::process<GControls::Lane>(channels, g, level);
+		}
+
+		Output &out = outputs[omap(VCA::OUT_OUTPUT, 0)];
+
+		out.setChannels(n);
+		for (std::size_t c=0; c<n; ++c)
+		{
+			out.setVoltage(channels.output[c], c);
+		}
+
+		for (std::size_t i=1; i<GTX__N; ++i)
+		{
+			outputs[omap(VCA::OUT_OUTPUT, i)].setVoltage(0.0f);
+		}
+
+		return hsum(sum);
+	}
+
+	static float hsum(float x)
+	{
+		return x;
+	}
+
+	static float hsum(simd::float_4 x)
+	{
+		return x.s[0] + x.s[1] + x.s[2] + x.s[3];
+	}
+
+	json_t *dataToJson() override
+	{
+		json_t *rootJ = json_object();
+		cables.save(rootJ);
+		return rootJ;
+	}
+
+	void dataFromJson(json_t *rootJ) override
+	{
+		cables.load(rootJ);
 	}
 };
 
@@ -145,6 +278,11 @@ struct GtxWidget : ModuleWidget
 		addInput(createInputCentered<GControls::PortInMed>(Vec(GControls::gx(0), GControls::gy(1)), module, VCABank::imap(VCA::EXP_INPUT, GTX__N)));
 		addInput(createInputCentered<GControls::PortInMed>(Vec(GControls::gx(0), GControls::gy(2)), module, VCABank::imap(VCA::IN_INPUT,  GTX__N)));
 	}
+
+	void appendContextMenu(Menu *menu) override
+	{
+		if (VCABank *bank = dynamic_cast<VCABank *>(module)) bank->cables.appendMenu(menu);
+	}
 };
 
 
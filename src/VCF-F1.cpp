@@ -30,65 +30,201 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 
 #include "Gratrix.hpp"
+#include <smmintrin.h>
 
-// The clipping function of a transistor pair is approximately tanh(x)
-// TODO: Put this in a lookup table. 5th order approx doesn't seem to cut it
 using simd::float_4;
 
-template <typename T>
+// tanh(x) by linear interpolation over 1024 segments, within 2.4e-5 of std::tanh.  Each segment is stored as
+// its start value and rise, so a lane gathers both with one 8-byte load.
+struct TanhTable {
+	static constexpr int SIZE = 1024;
+	static constexpr float RANGE = 8.0f;  // tanh(8) = 1 - 2e-7
+
+	alignas(16) float segment[SIZE][2];
+
+	TanhTable() {
+		for (int i = 0; i < SIZE; i++) {
+			double y0 = std::tanh((2.0 * i / SIZE - 1.0) * RANGE);
+			double y1 = std::tanh((2.0 * (i + 1) / SIZE - 1.0) * RANGE);
+			segment[i][0] = y0;
+			segment[i][1] = y1 - y0;
+		}
+	}
+
+	const __m64 *load(int i) const {
+		return reinterpret_cast<const __m64 *>(segment[i]);
+	}
+
+	float operator()(float x) const {
+		float p = clamp(x * (SIZE / 2 / RANGE) + SIZE / 2, 0.f, SIZE - 0.001f);
+		int i = static_cast<int>(p);
+		return segment[i][0] + segment[i][1] * (p - i);
+	}
+
+	float_4 operator()(float_4 x) const {
+		float_4 p = simd::clamp(x * (SIZE / 2 / RANGE) + SIZE / 2, 0.f, SIZE - 0.001f);
+		__m128i i = _mm_cvttps_epi32(p.v);
+
+		// Indices go straight from register to address; spilling them through memory stalls the eco solver
+		__m128 s01 = _mm_loadh_pi(_mm_loadl_pi(_mm_setzero_ps(), load(_mm_cvtsi128_si32(i))), load(_mm_extract_epi32(i, 1)));
+		__m128 s23 = _mm_loadh_pi(_mm_loadl_pi(_mm_setzero_ps(), load(_mm_extract_epi32(i, 2))), load(_mm_extract_epi32(i, 3)));
+		float_4 y0 = _mm_shuffle_ps(s01, s23, _MM_SHUFFLE(2, 0, 2, 0));
+		float_4 dy = _mm_shuffle_ps(s01, s23, _MM_SHUFFLE(3, 1, 3, 1));
+		return y0 + dy * (p - float_4(_mm_cvtepi32_ps(i)));
+	}
+};
+
+static const TanhTable tanhTable;
+
+// The clipping function of a transistor pair is approximately tanh(x).  The Pade approximant is within 0.024 of
+// it; the tanh table (TABLE) is within 2.4e-5 but makes the bank about 1.5 times as costly with RK4 and 1.3
+// times with eco, its gathers being slower than one division (see bench/tanh.cpp).
+template <bool TABLE, typename T>
 static T clip(T x) {
-	// return std::tanh(x);
+	if (TABLE)
+		return tanhTable(x);
+
 	// Pade approximant of tanh
 	x = simd::clamp(x, -3.f, 3.f);
 	return x * (27 + x * x) / (27 + 9 * x * x);
 }
 
+// Filter state for all voices is held structure-of-arrays.  T is the lane type the solver runs on and k
+// indexes a voice (T = float) or a group of four voices (T = simd::float_4).
 template <typename T>
 struct LadderFilter {
-	T omega0;
-	T resonance = 1;
-	T state[4];
-	T input;
+	GControls::VoiceArray<float> omega0;
+	GControls::VoiceArray<float> resonance{1.0f};
+	GControls::VoiceArray<float> state[4];
+	GControls::VoiceArray<float> input;
+	GControls::VoiceArray<float> memory[4];  // trapezoidal integrator states for processEco()
+	GControls::VoiceArray<float> stageGain;  // processEco()'s gains, made by setStep()
+	GControls::VoiceArray<float> memoryGain;
+	GControls::VoiceArray<float> loopGain;
 
 	LadderFilter() {
 		reset();
-		setCutoff(0);
 	}
 
 	void reset() {
 		for (int i = 0; i < 4; i++) {
-			state[i] = 0;
+			state[i].fill(0.0f);
+		}
+		input.fill(0.0f);
+		primeEco();
+	}
+
+	//! \brief Start the eco solver from wherever the RK4 solver left the ladder.
+	void primeEco() {
+		for (int i = 0; i < 4; i++) {
+			memory[i] = state[i];
 		}
 	}
 
-	void setCutoff(T cutoff) {
-		omega0 = 2 * T(M_PI) * cutoff;
+	//! \brief Silence voice k (T = float) or voices 4k..4k+3 (T = simd::float_4).
+	void clear(std::size_t k) {
+		for (int i = 0; i < 4; i++) {
+			state[i].store(k, T(0.0f));
+			memory[i].store(k, T(0.0f));
+		}
+		input.store(k, T(0.0f));
+	}
+
+	void setCutoff(std::size_t k, T cutoff) {
+		omega0.store(k, 2 * T(M_PI) * cutoff);
+	}
+
+	void setResonance(std::size_t k, T res) {
+		resonance.store(k, res);
 	}
 
-	void process(T input, T dt) {
-		dsp::stepRK4(T(0), dt, state, 4, [&](T t, const T x[], T dxdt[]) {
-			T inputt = crossfade(this->input, input, t / dt);
-			T inputc = clip(inputt - resonance * x[3]);
-			T yc0 = clip(x[0]);
-			T yc1 = clip(x[1]);
-			T yc2 = clip(x[2]);
-			T yc3 = clip(x[3]);
-
-			dxdt[0] = omega0 * (inputc - yc0);
-			dxdt[1] = omega0 * (yc0 - yc1);
-			dxdt[2] = omega0 * (yc1 - yc2);
-			dxdt[3] = omega0 * (yc2 - yc3);
+	//! \brief processEco()'s gains for steps of dt, from the cutoff and resonance already set.
+	void setStep(std::size_t k, T dt) {
+		T w = omega0.load<T>(k);
+		T r = resonance.load<T>(k);
+
+		// Prewarped integrator gain tan(w dt / 2), by a Pade approximant good to 1e-4 below 0.6 rad
+		T h = simd::fmin(w * dt * 0.5f, T(1.4f));
+		T g = h * (15 - h * h) / (15 - 6 * h * h);
+
+		T s = 1.f / (1.f + g);
+		T G = g * s;
+		stageGain.store(k, G);
+		memoryGain.store(k, s);
+		loopGain.store(k, 1.f / (1.f + r * (G * G) * (G * G)));
+	}
+
+	template <bool TABLE> void process(std::size_t k, T input, T dt) {
+		T w = omega0.load<T>(k);
+		T r = resonance.load<T>(k);
+		T last = this->input.load<T>(k);
+		T x[4];
+		for (int i = 0; i < 4; i++) {
+			x[i] = state[i].load<T>(k);
+		}
+
+		dsp::stepRK4(T(0), dt, x, 4, [&](T t, const T x[], T dxdt[]) {
+			T inputt = crossfade(last, input, t / dt);
+			T inputc = clip<TABLE>(inputt - r * x[3]);
+			T yc0 = clip<TABLE>(x[0]);
+			T yc1 = clip<TABLE>(x[1]);
+			T yc2 = clip<TABLE>(x[2]);
+			T yc3 = clip<TABLE>(x[3]);
+
+			dxdt[0] = w * (inputc - yc0);
+			dxdt[1] = w * (yc0 - yc1);
+			dxdt[2] = w * (yc1 - yc2);
+			dxdt[3] = w * (yc2 - yc3);
 		});
 
-		this->input = input;
+		for (int i = 0; i < 4; i++) {
+			state[i].store(k, x[i]);
+		}
+		this->input.store(k, input);
+	}
+
+	//! \brief Eco solver, a zero-delay-feedback ladder of four trapezoidal one-poles.
+	//!
+	//! Each stage's saturation is taken as clip(m) - m at its integrator state m, which runs half a step ahead of
+	//! its output, so stage i becomes a linear y_i = G (u_i + d_i) + s m_i with a known offset d_i.  The ladder
+	//! is then y_3 = G^4 u + B and the resonance loop u = input - r y_3 is solved exactly, with no unit delay,
+	//! before u is clipped.  G, s and the loop's 1 / (1 + r G^4) change only with the cutoff, resonance and
+	//! step, so setStep() makes them and a sample costs five clip()s against twenty for RK4.
+	template <bool TABLE> void processEco(std::size_t k, T input) {
+		T G = stageGain.load<T>(k);
+		T s = memoryGain.load<T>(k);
+		T r = resonance.load<T>(k);
+
+		// Stage i's offset, from its input's saturation less its own
+		T o[4];
+		T before = T(0.f);
+		for (int i = 0; i < 4; i++) {
+			T m = memory[i].load<T>(k);
+			T after = clip<TABLE>(m) - m;
+			o[i] = G * (before - after) + s * m;
+			before = after;
+		}
+
+		T B = ((o[0] * G + o[1]) * G + o[2]) * G + o[3];
+		T x = clip<TABLE>((input - r * B) * loopGain.load<T>(k));
+
+		for (int i = 0; i < 4; i++) {
+			T m = memory[i].load<T>(k);
+			T y = G * x + o[i];
+			memory[i].store(k, 2.f * y - m);
+			state[i].store(k, y);
+			x = y;
+		}
+		this->input.store(k, input);
 	}
 
-	T lowpass() {
-		return state[3];
+	// V = float reads one voice whatever lane type the solver runs on
+	template <typename V = T> V lowpass(std::size_t k) {
+		return state[3].load<V>(k);
 	}
-	T highpass() {
+	template <bool TABLE, typename V = T> V highpass(std::size_t k) {
 		// TODO This is incorrect when `resonance > 0`. Is the math wrong?
-		return clip((input - resonance * state[3]) - 4 * state[0] + 6 * state[1] - 4 * state[2] + state[3]);
+		return clip<TABLE>((input.load<V>(k) - resonance.load<V>(k) * state[3].load<V>(k)) - 4 * state[0].load<V>(k) + 6 * state[1].load<V>(k) - 4 * state[2].load<V>(k) + state[3].load<V>(k));
 	}
 };
 
@@ -117,20 +253,88 @@ struct VCF : GControls::MicroModule {
 		NUM_OUTPUTS
 	};
 
-	LadderFilter<float> filter;
+	static constexpr int MAX_OVERSAMPLE = 4;
+
+	// A voice is idle while its input and ladder stay below QUIET (-100 dB) with the resonance below
+	// SELF_OSCILLATION, where the bootstrap noise cannot start it ringing (that takes 10 res^2 = 4, at 0.63).
+	// IDLE_SAMPLES in a row, longer than the resamplers' round trip, and it sleeps.
+	static constexpr float QUIET = 1e-5f;
+	static constexpr float SELF_OSCILLATION = 0.5f;
+	static constexpr int IDLE_SAMPLES = 64;
+
+	// Half-band resampling around the ladder for one lane group, in stages of two so the cost follows the factor
+	template <typename T> struct Oversampler {
+		GControls::HalfBandUp  <T, 16> up2;       // 1x to 2x
+		GControls::HalfBandUp  <T,  6> up4;       // 2x to 4x
+		GControls::HalfBandDown<T, 16> down2[2];  // lowpass and highpass, 2x to 1x
+		GControls::HalfBandDown<T,  6> down4[2];  // 4x to 2x
+
+		void reset() {
+			up2.reset();
+			up4.reset();
+			for (auto &d : down2) d.reset();
+			for (auto &d : down4) d.reset();
+		}
+	};
+
+	typedef LadderFilter<GControls::Lane> Filter;
+	typedef std::array<Oversampler<GControls::Lane>, GControls::GROUPS> Resampler;
+
+	// Per-voice controls, turned into filter coefficients by the bank several voices at a time
+	struct Controls {
+		GControls::VoiceArray<float> input;
+		GControls::VoiceArray<float> noise;
+		GControls::VoiceArray<float> drive;
+		GControls::VoiceArray<float> res;
+		GControls::VoiceArray<float> pitch;  // V/oct about C4
+	};
+
+	// The controls the coefficients were last made from, NaN until first made, and the drive gain made with them.
+	// A lane group's coefficients are remade only when a lane's controls move by more than EPSILON, so static
+	// knobs and CVs cost nothing while moving CV stays sample-exact.
+	static constexpr float EPSILON = 1e-6f;
+
+	struct Coefficients {
+		GControls::VoiceArray<float> pitch{NAN};
+		GControls::VoiceArray<float> drive{NAN};
+		GControls::VoiceArray<float> res{NAN};
+		GControls::VoiceArray<float> gain;
+
+		void reset() {
+			pitch.fill(NAN);
+			drive.fill(NAN);
+			res.fill(NAN);
+		}
+	};
+
+	// Per-voice filter outputs at the bank's rate
+	struct Results {
+		GControls::VoiceArray<float> lowpass;
+		GControls::VoiceArray<float> highpass;
+	};
 
 	VCF() : MicroModule(NUM_PARAMS, NUM_INPUTS, NUM_OUTPUTS) {}
-	void step(float s_Rate);
-	void onReset() {
-		filter.reset();
+	void control(Controls &controls, std::size_t v);
+	bool idle(const Controls &controls, const Filter &filter, std::size_t v);
+	void output(const Results &results, std::size_t v, float gain);
+
+	template <typename T, bool ECO, bool TABLE> static void process(Controls &controls, Coefficients &coefficients, Filter &filter, Oversampler<T> &resampler, Results &results, std::size_t k, float deltaTime, int oversample);
+
+	// Whether x has moved from c by more than EPSILON in any lane; a NaN c always has
+	static bool moved(float x, float c) {
+		return !(std::fabs(x - c) <= EPSILON);
+	}
+	static bool moved(simd::float_4 x, simd::float_4 c) {
+		return simd::movemask(simd::fabs(x - c) <= EPSILON) != 0xF;
 	}
 };
 
 
 //============================================================================================================
 
-void VCF::step(float s_Rate) {
-	float input = inputs[IN_INPUT].getVoltage() / 5.0f;
+void VCF::control(Controls &controls, std::size_t v) {
+	controls.input[v] = inputs[IN_INPUT].getVoltage() / 5.0f;
+
 	float fineParam = params[FINE_PARAM].getValue();
 	fineParam = dsp::quadraticBipolar(fineParam * 2.f - 1.f) * 7.f / 12.f;
 
@@ -139,31 +343,99 @@ void VCF::step(float s_Rate) {
 	float freqParam = params[FREQ_PARAM].getValue();
 	freqParam = freqParam * 10.f - 5.f;
 
-	float driveParam = params[DRIVE_PARAM].getValue();
-	float drive = driveParam + inputs[DRIVE_INPUT].getVoltage() / 10.0f;
-	float gain = powf(100.0f, drive);
-	input *= gain;
-	// Add -120dB noise to bootstrap self-oscillation
-	input += 1e-6f * (2.0f*random::uniform() - 1.0f);
+	controls.drive[v] = params[DRIVE_PARAM].getValue() + inputs[DRIVE_INPUT].getVoltage() / 10.0f;
+	controls.res[v] = params[RES_PARAM].getValue() + inputs[RES_INPUT].getVoltage() / 10.0f;
+	controls.pitch[v] = freqParam + fineParam + freqCvParam * inputs[FREQ_INPUT].getVoltage();
+}
 
-	// Set resonance
-	float res = params[RES_PARAM].getValue() + inputs[RES_INPUT].getVoltage() / 10.0f;
-	res = clamp(res, 0.0f, 1.0f);
-	filter.resonance = simd::pow(res, 2) * 10.f;
+//! \brief Nothing would be heard from voice v: no output is patched, or it has gone quiet and cannot self-oscillate.
+bool VCF::idle(const Controls &controls, const Filter &filter, std::size_t v) {
+	if (!outputs[LPF_OUTPUT].isConnected() && !outputs[HPF_OUTPUT].isConnected()) return true;
+	if (controls.res[v] > SELF_OSCILLATION) return false;
+	if (std::fabs(controls.input[v]) * 100.f > QUIET) return false;  // 100 being the most drive can add
 
-	// Set cutoff frequency
-	float cutoffExp = freqParam + fineParam + freqCvParam * inputs[FREQ_INPUT].getVoltage();
-	cutoffExp = dsp::FREQ_C4 * simd::pow(2.f, cutoffExp);
-	cutoffExp = clamp(cutoffExp, 1.f, 8000.f);
-	filter.setCutoff(cutoffExp);
+	for (int i = 0; i < 4; i++)
+		if (std::fabs(filter.state[i][v]) > QUIET) return false;
 
+	return true;
+}
+
+//! \brief Gain, resonance and cutoff for voice k (T = float) or voices 4k..4k+3 (T = simd::float_4), then solve
+//! oversample (1, 2 or 4) times per sample, by the eco solver (ECO) or RK4, clipping through the tanh table (TABLE)
+//! or the Pade approximant.
+template <typename T, bool ECO, bool TABLE>
+void VCF::process(Controls &controls, Coefficients &coefficients, Filter &filter, Oversampler<T> &resampler, Results &results, std::size_t k, float deltaTime, int oversample) {
+	T pitch = controls.pitch.load<T>(k);
+	T drive = controls.drive.load<T>(k);
+	T res = controls.res.load<T>(k);
+
+	if (moved(pitch, coefficients.pitch.load<T>(k)) || moved(drive, coefficients.drive.load<T>(k)) || moved(res, coefficients.res.load<T>(k))) {
+		coefficients.pitch.store(k, pitch);
+		coefficients.drive.store(k, drive);
+		coefficients.res.store(k, res);
+		coefficients.gain.store(k, GControls::fastExp2(drive * 6.64385619f));  // 100^drive
+
+		// Set resonance
+		res = simd::clamp(res, 0.0f, 1.0f);
+		filter.setResonance(k, res * res * 10.f);
+
+		// Set cutoff frequency, the ladder staying stable to a higher limit the faster it runs
+		T cutoff = GControls::voltToFreq(pitch);
+		cutoff = simd::clamp(cutoff, 1.f, std::min(8000.f * oversample, 20000.f));
+		filter.setCutoff(k, cutoff);
+		filter.setStep(k, T(deltaTime / oversample));
+	}
+
+	T input = controls.input.load<T>(k) * coefficients.gain.load<T>(k) + controls.noise.load<T>(k);
 
 	// Push a sample to the state filter
-	filter.process(input, 1.0f/s_Rate);
+	auto step = [&](T x, T dt, T &lowpass, T &highpass) {
+		if (ECO)
+			filter.processEco<TABLE>(k, x);
+		else
+			filter.process<TABLE>(k, x, dt);
+		lowpass = filter.lowpass<T>(k);
+		highpass = filter.highpass<TABLE, T>(k);
+	};
 
+	T lowpass, highpass;
+	switch (oversample) {
+		case 1: {
+			step(input, T(deltaTime), lowpass, highpass);
+			break;
+		}
+		case 2: {
+			T x[2], lp[2], hp[2];
+			resampler.up2.process(input, x);
+			for (int i = 0; i < 2; i++) step(x[i], T(deltaTime / 2), lp[i], hp[i]);
+			lowpass = resampler.down2[0].process(lp);
+			highpass = resampler.down2[1].process(hp);
+			break;
+		}
+		default: {
+			T x[2], x4[4], lp[4], hp[4], lp2[2], hp2[2];
+			resampler.up2.process(input, x);
+			resampler.up4.process(x[0], &x4[0]);
+			resampler.up4.process(x[1], &x4[2]);
+			for (int i = 0; i < 4; i++) step(x4[i], T(deltaTime / 4), lp[i], hp[i]);
+			for (int i = 0; i < 2; i++) {
+				lp2[i] = resampler.down4[0].process(&lp[2 * i]);
+				hp2[i] = resampler.down4[1].process(&hp[2 * i]);
+			}
+			lowpass = resampler.down2[0].process(lp2);
+			highpass = resampler.down2[1].process(hp2);
+			break;
+		}
+	}
+
+	results.lowpass.store(k, lowpass);
+	results.highpass.store(k, highpass);
+}
+
+void VCF::output(const Results &results, std::size_t v, float gain) {
 	// Set outputs
-	outputs[LPF_OUTPUT].setVoltage(5.0f * filter.lowpass());
-	outputs[HPF_OUTPUT].setVoltage(5.0f * filter.highpass());
+	outputs[LPF_OUTPUT].setVoltage(5.0f * gain * results.lowpass[v]);
+	outputs[HPF_OUTPUT].setVoltage(5.0f * gain * results.highpass[v]);
 }
 
 
@@ -171,7 +443,38 @@ void VCF::step(float s_Rate) {
 
 struct VCFBank : Module
 {
+	enum Quality {
+		QUALITY_RK4,
+		QUALITY_ECO,
+		NUM_QUALITIES
+	};
+
+	enum Clipper {
+		CLIPPER_PADE,
+		CLIPPER_TABLE,
+		NUM_CLIPPERS
+	};
+
 	std::array<VCF, GTX__N> inst;
+	VCF::Controls controls;
+	VCF::Coefficients coefficients;
+	VCF::Filter filter;
+	VCF::Resampler resampler;
+	VCF::Results results;
+	GControls::Noise noise;
+	int quality = QUALITY_RK4;
+	int clipper = CLIPPER_PADE;
+	int oversample = 1;
+
+	// The solver, clipper and factor actually running, each faded out and back in around a change, as the two
+	// solvers' states differ, the clippers' curves differ and the resamplers restart
+	GControls::FadeSwitch<int> solver{QUALITY_RK4};
+	GControls::FadeSwitch<int> clipping{CLIPPER_PADE};
+	GControls::FadeSwitch<int> rate{1};
+
+	// Samples each voice has been idle in a row, and the lane groups asleep
+	GControls::VoiceArray<int> idle;
+	std::array<bool, GControls::GROUPS> asleep = {};
 
 	VCFBank() {
 		config(VCF::NUM_PARAMS, (GTX__N+1) * VCF::NUM_INPUTS, GTX__N * VCF::NUM_OUTPUTS);
@@ -180,6 +483,12 @@ struct VCFBank : Module
 		configParam(VCF::RES_PARAM, 0.0f, 1.0f, 0.0f, "Resonance", "%", 0.f, 100.f);
 		configParam(VCF::FREQ_CV_PARAM, -1.0f, 1.0f, 0.0f,  "Frequency modulation", "%", 0.f, 100.f);
 		configParam(VCF::DRIVE_PARAM, 0.0f, 1.0f, 0.0f, "Drive", "", 0, 11);
+
+		for (std::size_t i=0; i<GTX__N; ++i)
+		{
+			for (std::size_t p=0; p<VCF::NUM_PARAMS;  ++p) inst[i].params .bind(p, params[p]);
+			for (std::size_t p=0; p<VCF::NUM_OUTPUTS; ++p) inst[i].outputs.bind(p, outputs[omap(p, i)]);
+		}
 	}
 
 	static std::size_t imap(std::size_t port, std::size_t bank)
@@ -194,24 +503,117 @@ struct VCFBank : Module
 
 	void process(const ProcessArgs& args) override
 	{
-		float sample_Rate = args.sampleRate;
+		// Add -120dB noise to bootstrap self-oscillation
+		noise.uniform(controls.noise, 1e-6f);
+
 		for (std::size_t i=0; i<GTX__N; ++i)
 		{
-			for (std::size_t p=0; p<VCF::NUM_PARAMS;  ++p) inst[i].params[p]  = params[p];
-			for (std::size_t p=0; p<VCF::NUM_INPUTS;  ++p) inst[i].inputs[p]  = inputs[imap(p, i)].isConnected() ? inputs[imap(p, i)] : inputs[imap(p, GTX__N)];
-			for (std::size_t p=0; p<VCF::NUM_OUTPUTS; ++p) inst[i].outputs[p] = outputs[omap(p, i)];
+			for (std::size_t p=0; p<VCF::NUM_INPUTS;  ++p) inst[i].inputs.bind(p, inputs[imap(p, i)].isConnected() ? inputs[imap(p, i)] : inputs[imap(p, GTX__N)]);
+
+			inst[i].control(controls, i);
+
+			if (!inst[i].idle(controls, filter, i)) idle[i] = 0;
+			else if (idle[i] < VCF::IDLE_SAMPLES) idle[i]++;
+		}
+
+		// 5 ms each way
+		if (solver.process(quality, args.sampleTime / 0.005f))
+		{
+			if (solver.active == QUALITY_ECO) filter.primeEco();
+		}
 
-			inst[i].step(sample_Rate);
+		clipping.process(clipper, args.sampleTime / 0.005f);
 
-			for (std::size_t p=0; p<VCF::NUM_OUTPUTS; ++p) outputs[omap(p, i)].setVoltage(inst[i].outputs[p].value);
+		if (rate.process(oversample, args.sampleTime / 0.005f))
+		{
+			for (auto &r : resampler) r.reset();
+			coefficients.reset();  // the cutoff limit follows the factor
+		}
+
+		for (std::size_t g=0; g<GControls::GROUPS; ++g)
+		{
+			if (!wake(g)) continue;
+
+			bool table = clipping.active == CLIPPER_TABLE;
+
+			if (solver.active == QUALITY_ECO)
+			{
+				if (table) processGroup<true,  true >(g, args.sampleTime);
+				else       processGroup<true,  false>(g, args.sampleTime);
+			}
+			else
+			{
+				if (table) processGroup<false, true >(g, args.sampleTime);
+				else       processGroup<false, false>(g, args.sampleTime);
+			}
+		}
+
+		for (std::size_t i=0; i<GTX__N; ++i)
+		{
+			inst[i].output(results, i, rate.gain * solver.gain * clipping.gain);
 		}
 	}
 
+	template <bool ECO, bool TABLE>
+	void processGroup(std::size_t g, float sampleTime)
+	{
+		VCF::process<GControls::Lane, ECO, TABLE>(controls, coefficients, filter, resampler[g], results, g, sampleTime, rate.active);
+	}
+
+	//! \brief Whether lane group g has a voice awake.  A group falling asleep is silenced, and so wakes from rest.
+	bool wake(std::size_t g)
+	{
+		bool awake = false;
+		for (std::size_t v=g*GControls::LANES; v<(g+1)*GControls::LANES && v<GTX__N; ++v) awake |= idle[v] < VCF::IDLE_SAMPLES;
+
+		if (!awake && !asleep[g])
+		{
+			filter.clear(g);
+			resampler[g].reset();
+			results.lowpass .store(g, GControls::Lane(0.0f));
+			results.highpass.store(g, GControls::Lane(0.0f));
+		}
+
+		asleep[g] = !awake;
+		return awake;
+	}
+
+	void onSampleRateChange() override
+	{
+		coefficients.reset();  // the eco solver's gains follow the step
+	}
+
 	void onReset() override
 	{
-		for (std::size_t i=0; i<GTX__N; ++i)
+		filter.reset();
+		for (auto &r : resampler) r.reset();
+	}
+
+	json_t *dataToJson() override
+	{
+		json_t *rootJ = json_object();
+		json_object_set_new(rootJ, "quality", json_integer(quality));
+		json_object_set_new(rootJ, "clipper", json_integer(clipper));
+		json_object_set_new(rootJ, "oversample", json_integer(oversample));
+		return rootJ;
+	}
+
+	void dataFromJson(json_t *rootJ) override
+	{
+		if (json_t *qualityJ = json_object_get(rootJ, "quality"))
 		{
-			inst[i].onReset();
+			quality = clamp(static_cast<int>(json_integer_value(qualityJ)), 0, NUM_QUALITIES - 1);
+		}
+
+		if (json_t *clipperJ = json_object_get(rootJ, "clipper"))
+		{
+			clipper = clamp(static_cast<int>(json_integer_value(clipperJ)), 0, NUM_CLIPPERS - 1);
+		}
+
+		if (json_t *oversampleJ = json_object_get(rootJ, "oversample"))
+		{
+			int o = static_cast<int>(json_integer_value(oversampleJ));
+			if (o == 1 || o == 2 || o == 4) oversample = o;
 		}
 	}
 };
@@ -270,6 +672,66 @@ struct GtxWidget : ModuleWidget
 		addInput(createInputCentered<GControls::PortInMed>(Vec(GControls::gx(1), GControls::gy(2)), module, VCFBank::imap(VCF::DRIVE_INPUT, GTX__N)));
 		addInput(createInputCentered<GControls::PortInMed>(Vec(GControls::gx(0), GControls::gy(2)), module, VCFBank::imap(VCF::IN_INPUT,    GTX__N)));
 	}
+
+	void appendContextMenu(Menu *menu) override
+	{
+		VCFBank *bank = dynamic_cast<VCFBank *>(module);
+		if (!bank) return;
+
+		struct QualityItem : MenuItem
+		{
+			VCFBank *bank;
+			int quality;
+			void onAction(const event::Action &e) override { bank->quality = quality; }
+		};
+
+		auto add = [&](std::string text, int quality)
+		{
+			QualityItem *item = createMenuItem<QualityItem>(text, CHECKMARK(bank->quality == quality));
+			item->bank = bank;
+			item->quality = quality;
+			menu->addChild(item);
+		};
+
+		menu->addChild(new MenuSeparator);
+		menu->addChild(createMenuLabel("Quality"));
+		add("Runge-Kutta (RK4)", VCFBank::QUALITY_RK4);
+		add("Eco (zero-delay feedback)", VCFBank::QUALITY_ECO);
+
+		struct ClipperItem : MenuItem
+		{
+			VCFBank *bank;
+			int clipper;
+			void onAction(const event::Action &e) override { bank->clipper = clipper; }
+		};
+
+		menu->addChild(new MenuSeparator);
+		menu->addChild(createMenuLabel("Clipper"));
+		for (int c = 0; c < VCFBank::NUM_CLIPPERS; ++c)
+		{
+			ClipperItem *item = createMenuItem<ClipperItem>(c == VCFBank::CLIPPER_TABLE ? "tanh table" : "Pade approximant", CHECKMARK(bank->clipper == c));
+			item->bank = bank;
+			item->clipper = c;
+			menu->addChild(item);
+		}
+
+		struct OversampleItem : MenuItem
+		{
+			VCFBank *bank;
+			int oversample;
+			void onAction(const event::Action &e) override { bank->oversample = oversample; }
+		};
+
+		menu->addChild(new MenuSeparator);
+		menu->addChild(createMenuLabel("Oversampling"));
+		for (int o = 1; o <= VCF::MAX_OVERSAMPLE; o *= 2)
+		{
+			OversampleItem *item = createMenuItem<OversampleItem>(std::to_string(o) + "x", CHECKMARK(bank->oversample == o));
+			item->bank = bank;
+			item->oversample = o;
+			menu->addChild(item);
+		}
+	}
 };
 
 
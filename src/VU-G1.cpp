@@ -27,6 +27,30 @@ struct VU_G1 : Module
 		NUM_LIGHTS = 10  // N
 	};
 
+	enum Meters {
+		METER_PEAK,
+		METER_RMS,
+		NUM_METERS
+	};
+
+	// The audio thread only keeps each voice's running peak and sum of squares; every BLOCK samples these
+	// become the meter level, with attack and release ballistics, and the lights are set from it
+	static constexpr std::size_t BLOCK   = 512;
+	static constexpr float       ATTACK  = 0.010f;  // time constants in seconds
+	static constexpr float       RELEASE = 0.300f;
+
+	GControls::VoiceArray<float> in;     // this sample's inputs, so they load by lane group
+	GControls::VoiceArray<float> peak;
+	GControls::VoiceArray<float> square;
+	GControls::VoiceArray<float> level;  // volts
+	std::size_t count = 0;
+
+	float sampleTime = NAN;
+	float attack;  // per-block ballistic coefficients, remade when the sample rate changes
+	float release;
+
+	int meter = METER_PEAK;
+
 	VU_G1() {config(NUM_PARAMS, (GTX__N+1) * NUM_INPUTS, NUM_OUTPUTS, GTX__N * NUM_LIGHTS);}
 
 	static constexpr std::size_t imap(std::size_t port, std::size_t bank)
@@ -36,19 +60,88 @@ struct VU_G1 : Module
 
 	void process(const ProcessArgs& args) override
 	{
+		float bus = inputs[imap(IN1_INPUT, GTX__N)].getVoltage();
+
 		for (std::size_t i=0; i<GTX__N; ++i)
 		{
-			float input = inputs[imap(IN1_INPUT, i)].isConnected() ? inputs[imap(IN1_INPUT, i)].getVoltage() : inputs[imap(IN1_INPUT, GTX__N)].getVoltage();
-			float dB    = logf(fabsf(input * 0.1f)) * (10.0f / logf(20.0f));
-			float dB2   = dB * (1.0f / 3.0f);
+			in[i] = GControls::normalled(inputs[imap(IN1_INPUT, i)], bus);
+		}
+
+		for (std::size_t k=0; k<GControls::GROUPS; ++k)
+		{
+			GControls::Lane x = in.load<GControls::Lane>(k);
+
+			peak.store(k, simd::fmax(peak.load<GControls::Lane>(k), simd::fabs(x)));
+			square.store(k, square.load<GControls::Lane>(k) + x * x);
+		}
+
+		if (++count >= BLOCK)
+		{
+			count = 0;
+			updateMeter(args.sampleTime);
+		}
+	}
+
+	//--------------------------------------------------------------------------------------------------------
+	//! \brief Move the meter level on by one block and redraw the light ladders.
+
+	void updateMeter(float sampleTime)
+	{
+		if (sampleTime != this->sampleTime)
+		{
+			this->sampleTime = sampleTime;
+			attack  = -std::expm1(-(BLOCK * sampleTime) / ATTACK);
+			release = -std::expm1(-(BLOCK * sampleTime) / RELEASE);
+		}
+
+		GControls::VoiceArray<float> dB2;
+
+		for (std::size_t k=0; k<GControls::GROUPS; ++k)
+		{
+			GControls::Lane value = (meter == METER_RMS) ? simd::sqrt(square.load<GControls::Lane>(k) * (1.0f / BLOCK)) : peak.load<GControls::Lane>(k);
+			GControls::Lane l     = level.load<GControls::Lane>(k);
 
+			l += simd::ifelse(value > l, GControls::Lane(attack), GControls::Lane(release)) * (value - l);
+
+			level.store(k, l);
+			dB2.store(k, simd::log(l * 0.1f) * (10.0f / logf(20.0f) / 3.0f));  // one light every 3 dB
+		}
+
+		peak.fill(0.0f);
+		square.fill(0.0f);
+
+		for (std::size_t i=0; i<GTX__N; ++i)
+		{
 			for (int j = 0; j < NUM_LIGHTS; j++)
 			{
-				float b = clamp(dB2 + (j+1), 0.0f, 1.0f);
-				lights[NUM_LIGHTS * i + j].setSmoothBrightness(b * 0.9f, 10);
+				float b = clamp(dB2[i] + (j+1), 0.0f, 1.0f);
+				lights[NUM_LIGHTS * i + j].setBrightness(b * 0.9f);
 			}
 		}
 	}
+
+	void onReset() override
+	{
+		peak.fill(0.0f);
+		square.fill(0.0f);
+		level.fill(0.0f);
+		count = 0;
+	}
+
+	json_t *dataToJson() override
+	{
+		json_t *rootJ = json_object();
+		json_object_set_new(rootJ, "meter", json_integer(meter));
+		return rootJ;
+	}
+
+	void dataFromJson(json_t *rootJ) override
+	{
+		if (json_t *meterJ = json_object_get(rootJ, "meter"))
+		{
+			meter = clamp(static_cast<int>(json_integer_value(meterJ)), 0, NUM_METERS - 1);
+		}
+	}
 };
 
 
@@ -98,6 +191,32 @@ struct GtxWidget : ModuleWidget
 			}
 		}
 	}
+
+	void appendContextMenu(Menu *menu) override
+	{
+		VU_G1 *vu = dynamic_cast<VU_G1 *>(module);
+		if (!vu) return;
+
+		struct MeterItem : MenuItem
+		{
+			VU_G1 *vu;
+			int meter;
+			void onAction(const event::Action &e) override { vu->meter = meter; }
+		};
+
+		auto add = [&](std::string text, int meter)
+		{
+			MeterItem *item = createMenuItem<MeterItem>(text, CHECKMARK(vu->meter == meter));
+			item->vu = vu;
+			item->meter = meter;
+			menu->addChild(item);
+		};
+
+		menu->addChild(new MenuSeparator);
+		menu->addChild(createMenuLabel("Meter"));
+		add("Peak", VU_G1::METER_PEAK);
+		add("RMS", VU_G1::METER_RMS);
+	}
 };
 
 